@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include "arena.hpp"
+#include "errors.hpp"
+
+namespace cshanty{
+
+static const size_t ARENA_ALIGN = alignof(std::max_align_t);
+static const size_t FIRST_CHUNK_SIZE = 64 * 1024;
+static const size_t MAX_CHUNK_SIZE = 64 * 1024 * 1024;
+
+static thread_local Arena * currentArena = nullptr;
+
+static size_t alignUp(size_t size){
+	return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+Arena::Arena()
+: chunks(nullptr), cursor(nullptr), limit(nullptr), 
+  nextChunkSize(FIRST_CHUNK_SIZE), used(0), reserved(0), count(0){
+}
+
+Arena::~Arena(){
+	Chunk * chunk = chunks;
+	while (chunk != nullptr){
+		Chunk * next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+}
+
+//Chunks double in size (up to a limit), so releasing the 
+// arena frees only a handful of blocks no matter how many 
+// objects were placed in it
+void Arena::grow(size_t atLeast){
+	size_t header = alignUp(sizeof(Chunk));
+	size_t size = nextChunkSize;
+	while (size < atLeast + header){ size *= 2; }
+	if (nextChunkSize < MAX_CHUNK_SIZE){ nextChunkSize *= 2; }
+
+	Chunk * chunk = static_cast<Chunk *>(malloc(size));
+	if (chunk == nullptr){ throw std::bad_alloc(); }
+	chunk->next = chunks;
+	chunk->size = size;
+	chunks = chunk;
+	reserved += size;
+
+	cursor = reinterpret_cast<char *>(chunk) + header;
+	limit = reinterpret_cast<char *>(chunk) + size;
+}
+
+void * Arena::allocate(size_t size){
+	size = alignUp(size == 0 ? 1 : size);
+	if (static_cast<size_t>(limit - cursor) < size){
+		grow(size);
+	}
+	void * result = cursor;
+	cursor += size;
+	used += size;
+	count++;
+	return result;
+}
+
+Arena * Arena::current(){
+	return currentArena;
+}
+
+//Nothing frees arena objects one at a time, so placing one on
+// the heap would leak it
+void * Arena::allocateCurrent(size_t size){
+	if (currentArena == nullptr){
+		throw new InternalError("Arena object created with no current arena");
+	}
+	return currentArena->allocate(size);
+}
+
+Arena::Scope::Scope(Arena * arena) : previous(currentArena){
+	currentArena = arena;
+}
+
+Arena::Scope::~Scope(){
+	currentArena = previous;
+}
+
+} //End namespace cshanty
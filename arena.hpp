@@ -0,0 +1,103 @@
+#ifndef CSHANTY_ARENA_HPP
+#define CSHANTY_ARENA_HPP
+
+#include <cstddef>
+#include <list>
+#include <new>
+
+namespace cshanty{
+
+//A bump allocator that owns the storage of everything built
+// while compiling one input: tokens, positions, AST nodes and 
+// the lists that hold them. None of these objects are ever 
+// freed individually; all of their storage is released at once
+// when the arena is destroyed.
+class Arena{
+public:
+	Arena();
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	void * allocate(size_t size);
+
+	//Bytes handed out by allocate (including alignment padding)
+	size_t bytesUsed() const { return used; }
+	//Bytes obtained from the system for chunks
+	size_t bytesReserved() const { return reserved; }
+	size_t allocations() const { return count; }
+
+	//The arena that arena-allocated objects created by this 
+	// thread are placed in, or nullptr if there is none
+	static Arena * current();
+
+	//Allocate from the current arena. Throws an InternalError
+	// if this thread has no current arena
+	static void * allocateCurrent(size_t size);
+
+	//Makes an arena current for the calling thread for the
+	// lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(Arena * arena);
+		~Scope();
+	private:
+		Arena * previous;
+	};
+private:
+	struct Chunk{
+		Chunk * next;
+		size_t size;
+	};
+	void grow(size_t atLeast);
+
+	Chunk * chunks;
+	char * cursor;
+	char * limit;
+	size_t nextChunkSize;
+	size_t used;
+	size_t reserved;
+	size_t count;
+};
+
+//Classes derived from ArenaObject are placed in the current 
+// arena when created with new. Their storage is owned by the
+// arena, so deleting them does nothing.
+class ArenaObject{
+public:
+	static void * operator new(size_t size){ 
+		return Arena::allocateCurrent(size);
+	}
+	static void operator delete(void *){ }
+};
+
+//A (stateless) standard allocator over the current arena, so
+// that containers in the AST keep their nodes there too.
+template <typename T>
+class ArenaAllocator{
+public:
+	using value_type = T;
+	ArenaAllocator(){ }
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>&){ }
+	T * allocate(size_t n){
+		return static_cast<T *>(Arena::allocateCurrent(n * sizeof(T)));
+	}
+	void deallocate(T *, size_t){ }
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>&) const { return true; }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+//The list type used throughout the AST. Both the list itself
+// and its elements live in the current arena.
+template <typename T>
+class ArenaList : public std::list<T, ArenaAllocator<T>>, public ArenaObject{
+public:
+	using std::list<T, ArenaAllocator<T>>::list;
+};
+
+} //End namespace cshanty
+
+#endif
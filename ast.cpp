@@ -1,9 +1,9 @@
 #include "ast.hpp"
 
-cshanty::ProgramNode::ProgramNode(std::list<DeclNode *> * globalsIn)
-: ASTNode(new Position(0,0,0,0)), myGlobals(globalsIn){
+cshanty::ProgramNode::ProgramNode(ArenaList<DeclNode *> * globalsIn)
+: ASTNode(), myGlobals(globalsIn){
 	if (!globalsIn->empty()){
-		myPos->expand(
+		myPos.expand(
 			myGlobals->front()->pos(),
 			myGlobals->back()->pos()
 		);
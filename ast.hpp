@@ -5,6 +5,12 @@
 #include <sstream>
 #include <string.h>
 #include <list>
+#include "arena.hpp"
+#include "ast_file.hpp"
+#include "interner.hpp"
+#include "node_ids.hpp"
+#include "source_buffer.hpp"
+#include "symbol_coord.hpp"
 #include "tokens.hpp"
 #include "types.hpp"
 
@@ -12,6 +18,7 @@ namespace cshanty {
 
 class NameAnalysis;
 class TypeAnalysis;
+class AstWriter;
 
 class SymbolTable;
 class SemSymbol;
@@ -26,28 +33,37 @@ class ExpNode;
 class LValNode;
 class IDNode;
 
-class ASTNode{
+class ASTNode : public ArenaObject{
 public:
-	ASTNode(Position * pos) : myPos(pos){ }
+	ASTNode(const Position * pos) 
+	: myId(NodeIds::nextCurrent()), myPos(*pos){ }
 	virtual void unparse(std::ostream&, int) = 0;
-	Position * pos() { return myPos; };
+	//Dense, in order of construction, within a compilation
+	NodeId nodeId() const { return myId; }
+	Position * pos() { return &myPos; };
 	std::string posStr(){ return pos()->span(); }
 	virtual bool nameAnalysis(SymbolTable *) = 0;
+	//Hand this node (after its children) to the writer of a 
+	// .csast file, returning the node's index in the file
+	virtual uint32_t serialize(AstWriter * out) = 0;
 	//Note that there is no ASTNode::typeAnalysis. To allow
 	// for different type signatures, type analysis is 
 	// implemented as needed in various subclasses
 protected:
-	Position * myPos;
+	ASTNode() : myId(NodeIds::nextCurrent()), myPos(){ }
+	NodeId myId;
+	Position myPos;
 };
 
 class ProgramNode : public ASTNode{
 public:
-	ProgramNode(std::list<DeclNode *> * globalsIn);
+	ProgramNode(ArenaList<DeclNode *> * globalsIn);
 	void unparse(std::ostream&, int) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *);
 private:
-	std::list<DeclNode *> * myGlobals;
+	ArenaList<DeclNode *> * myGlobals;
 };
 
 class ExpNode : public ASTNode{
@@ -70,17 +86,27 @@ public:
 
 class IDNode : public LValNode{
 public:
-	IDNode(Position * p, std::string nameIn)
+	IDNode(Position * p, SymbolId nameIn)
 	: LValNode(p), name(nameIn), mySymbol(nullptr){}
-	std::string getName(){ return name; }
+	SymbolId getId() const { return name; }
+	const std::string& getName() const { 
+		return Interner::current()->str(name);
+	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol() const { return mySymbol; }
+	//Where the variable this ID names lives (unresolved for
+	// IDs that name functions and records)
+	SymbolCoord getCoord() const { return myCoord; }
+	//Restore the coord of an ID loaded from a resolved .csast
+	void setCoord(SymbolCoord coord){ myCoord = coord; }
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 private:
-	std::string name;
+	SymbolId name;
 	SemSymbol * mySymbol;
+	SymbolCoord myCoord;
 };
 
 class IndexNode : public LValNode{
@@ -91,6 +117,7 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 private:
@@ -110,8 +137,9 @@ public:
 class RecordTypeNode : public TypeNode{
 public:
 	RecordTypeNode(Position * p, IDNode * IDin)
-	:TypeNode(p), myID(IDin) { }
+	:TypeNode(p), myID(IDin), myType(nullptr) { }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual const DataType * getType() const override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
@@ -139,6 +167,7 @@ public:
 	VarDeclNode(Position * p, TypeNode * typeIn, IDNode * IDIn)
 	: DeclNode(p), myType(typeIn), myID(IDIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	IDNode * ID(){ return myID; }
 	TypeNode * getTypeNode(){ return myType; }
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
@@ -150,14 +179,15 @@ private:
 
 class RecordTypeDeclNode : public DeclNode{
 public:
-	RecordTypeDeclNode(Position *p, IDNode *id, std::list<VarDeclNode*> *body)
+	RecordTypeDeclNode(Position *p, IDNode *id, ArenaList<VarDeclNode *> *body)
 	: DeclNode(p), myID(id), myFields(body){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
 	IDNode * myID;
-	std::list<VarDeclNode *> * myFields;
+	ArenaList<VarDeclNode *> * myFields;
 };
 
 class FormalDeclNode : public VarDeclNode{
@@ -165,32 +195,34 @@ public:
 	FormalDeclNode(Position * p, TypeNode * type, IDNode * id) 
 	: VarDeclNode(p, type, id){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 };
 
 class FnDeclNode : public DeclNode{
 public:
 	FnDeclNode(Position * p, 
 	  TypeNode * retTypeIn, IDNode * idIn,
-	  std::list<FormalDeclNode *> * formalsIn,
-	  std::list<StmtNode *> * bodyIn)
+	  ArenaList<FormalDeclNode *> * formalsIn,
+	  ArenaList<StmtNode *> * bodyIn)
 	: DeclNode(p), myRetType(retTypeIn), myID(idIn),
 	  myFormals(formalsIn), myBody(bodyIn){ 
 	}
 	IDNode * ID() const { return myID; }
-	std::list<FormalDeclNode *> * getFormals() const{
+	ArenaList<FormalDeclNode *> * getFormals() const{
 		return myFormals;
 	}
 	virtual TypeNode * getRetTypeNode() {
 		return myRetType;
 	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
 	TypeNode * myRetType;
 	IDNode * myID;
-	std::list<FormalDeclNode *> * myFormals;
-	std::list<StmtNode *> * myBody;
+	ArenaList<FormalDeclNode *> * myFormals;
+	ArenaList<StmtNode *> * myBody;
 };
 
 class AssignStmtNode : public StmtNode{
@@ -198,6 +230,7 @@ public:
 	AssignStmtNode(Position * p, AssignExpNode * expIn)
 	: StmtNode(p), myExp(expIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
@@ -209,6 +242,7 @@ public:
 	ReceiveStmtNode(Position * p, LValNode * dstIn)
 	: StmtNode(p), myDst(dstIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
@@ -220,6 +254,7 @@ public:
 	ReportStmtNode(Position * p, ExpNode * srcIn)
 	: StmtNode(p), mySrc(srcIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
@@ -231,6 +266,7 @@ public:
 	PostDecStmtNode(Position * p, LValNode * lvalIn)
 	: StmtNode(p), myLVal(lvalIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
@@ -242,6 +278,7 @@ public:
 	PostIncStmtNode(Position * p, LValNode * lvalIn)
 	: StmtNode(p), myLVal(lvalIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
@@ -251,43 +288,46 @@ private:
 class IfStmtNode : public StmtNode{
 public:
 	IfStmtNode(Position * p, ExpNode * condIn,
-	  std::list<StmtNode *> * bodyIn)
+	  ArenaList<StmtNode *> * bodyIn)
 	: StmtNode(p), myCond(condIn), myBody(bodyIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	ArenaList<StmtNode *> * myBody;
 };
 
 class IfElseStmtNode : public StmtNode{
 public:
 	IfElseStmtNode(Position * p, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyTrueIn,
-	  std::list<StmtNode *> * bodyFalseIn)
+	  ArenaList<StmtNode *> * bodyTrueIn,
+	  ArenaList<StmtNode *> * bodyFalseIn)
 	: StmtNode(p), myCond(condIn),
 	  myBodyTrue(bodyTrueIn), myBodyFalse(bodyFalseIn) { }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBodyTrue;
-	std::list<StmtNode *> * myBodyFalse;
+	ArenaList<StmtNode *> * myBodyTrue;
+	ArenaList<StmtNode *> * myBodyFalse;
 };
 
 class WhileStmtNode : public StmtNode{
 public:
 	WhileStmtNode(Position * p, ExpNode * condIn, 
-	  std::list<StmtNode *> * bodyIn)
+	  ArenaList<StmtNode *> * bodyIn)
 	: StmtNode(p), myCond(condIn), myBody(bodyIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
 	ExpNode * myCond;
-	std::list<StmtNode *> * myBody;
+	ArenaList<StmtNode *> * myBody;
 };
 
 class ReturnStmtNode : public StmtNode{
@@ -295,6 +335,7 @@ public:
 	ReturnStmtNode(Position * p, ExpNode * exp)
 	: StmtNode(p), myExp(exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
@@ -304,16 +345,17 @@ private:
 class CallExpNode : public ExpNode{
 public:
 	CallExpNode(Position * p, IDNode * id,
-	  std::list<ExpNode *> * argsIn)
+	  ArenaList<ExpNode *> * argsIn)
 	: ExpNode(p), myID(id), myArgs(argsIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void unparseNested(std::ostream& out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 	bool isFnCall() { return true; }
 private:
 	IDNode * myID;
-	std::list<ExpNode *> * myArgs;
+	ArenaList<ExpNode *> * myArgs;
 };
 
 class BinaryExpNode : public ExpNode{
@@ -322,6 +364,7 @@ public:
 	: ExpNode(p), myExp1(lhs), myExp2(rhs) { }
 	bool nameAnalysis(SymbolTable * symTab) override;
 protected:
+	uint32_t serializeAs(AstWriter * out, AstKind kind);
 	ExpNode * myExp1;
 	ExpNode * myExp2;
 };
@@ -331,6 +374,7 @@ public:
 	PlusNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -339,6 +383,7 @@ public:
 	MinusNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -347,6 +392,7 @@ public:
 	TimesNode(Position * p, ExpNode * e1In, ExpNode * e2In)
 	: BinaryExpNode(p, e1In, e2In){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -355,6 +401,7 @@ public:
 	DivideNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -363,6 +410,7 @@ public:
 	AndNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -371,6 +419,7 @@ public:
 	OrNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -379,6 +428,7 @@ public:
 	EqualsNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -387,6 +437,7 @@ public:
 	NotEqualsNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -395,6 +446,7 @@ public:
 	LessNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -403,6 +455,7 @@ public:
 	LessEqNode(Position * pos, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(pos, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -411,6 +464,7 @@ public:
 	GreaterNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -419,6 +473,7 @@ public:
 	GreaterEqNode(Position * p, ExpNode * e1, ExpNode * e2)
 	: BinaryExpNode(p, e1, e2){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
 
@@ -439,6 +494,7 @@ public:
 	NegNode(Position * p, ExpNode * exp)
 	: UnaryExpNode(p, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
@@ -448,6 +504,7 @@ public:
 	NotNode(Position * p, ExpNode * exp)
 	: UnaryExpNode(p, exp){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta) override;
 };
@@ -456,6 +513,7 @@ class VoidTypeNode : public TypeNode{
 public:
 	VoidTypeNode(Position * p) : TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual const DataType * getType() const override;
 };
 
@@ -463,6 +521,7 @@ class IntTypeNode : public TypeNode{
 public:
 	IntTypeNode(Position * p): TypeNode(p){}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual const DataType * getType() const override;
 };
 
@@ -470,6 +529,7 @@ class BoolTypeNode : public TypeNode{
 public:
 	BoolTypeNode(Position * p): TypeNode(p) { }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual const DataType * getType() const override;
 };
 
@@ -477,6 +537,7 @@ class StringTypeNode : public TypeNode{
 public:
 	StringTypeNode(Position * p): TypeNode(p) { }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	virtual const DataType * getType() const override;
 };
 
@@ -486,6 +547,7 @@ public:
 	AssignExpNode(Position * p, LValNode * dstIn, ExpNode * srcIn)
 	: ExpNode(p), myDst(dstIn), mySrc(srcIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 private:
@@ -501,6 +563,7 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 private:
@@ -509,16 +572,20 @@ private:
 
 class StrLitNode : public ExpNode{
 public:
-	StrLitNode(Position * p, const std::string strIn)
+	StrLitNode(Position * p, SourceView strIn)
 	: ExpNode(p), myStr(strIn){ }
 	virtual void unparseNested(std::ostream& out) override{
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable *) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 private:
-	 const std::string myStr;
+	//The literal, quotes and all, as it appears in the input 
+	// (source or .csast), which outlives the AST. Nodes are 
+	// never destroyed, so they can't own a std::string.
+	const SourceView myStr;
 };
 
 class TrueNode : public ExpNode{
@@ -528,6 +595,7 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 };
@@ -539,6 +607,7 @@ public:
 		unparse(out, 0);
 	}
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	virtual void typeAnalysis(TypeAnalysis *) override;
 };
@@ -548,6 +617,7 @@ public:
 	CallStmtNode(Position * p, CallExpNode * expIn)
 	: StmtNode(p), myCallExp(expIn){ }
 	void unparse(std::ostream& out, int indent) override;
+	uint32_t serialize(AstWriter * out) override;
 	bool nameAnalysis(SymbolTable * symTab) override;
 	void typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) override;
 private:
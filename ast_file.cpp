@@ -0,0 +1,402 @@
+#include <cstring>
+#include "ast.hpp"
+#include "ast_file.hpp"
+#include "errors.hpp"
+
+namespace cshanty{
+
+static const char AST_MAGIC[8] = {'C', 'S', 'A', 'S', 'T', '\0', '\0', '\0'};
+
+const uint32_t AstHeader::VERSION;
+const uint32_t AstHeader::RESOLVED;
+const uint32_t AstRecord::NONE;
+
+const char * astKindName(AstKind kind){
+	static const char * const names[] = {
+		"Program",
+		"VoidType", "IntType", "BoolType", "StringType", "RecordType",
+		"VarDecl", "FormalDecl", "RecordTypeDecl", "FnDecl",
+		"AssignStmt", "ReceiveStmt", "ReportStmt", "PostDecStmt",
+		"PostIncStmt", "IfStmt", "IfElseStmt", "WhileStmt", "ReturnStmt",
+		"CallStmt",
+		"ID", "Index", "CallExp",
+		"Plus", "Minus", "Times", "Divide", "And", "Or", "Equals", 
+		"NotEquals", "Less", "LessEq", "Greater", "GreaterEq", "Neg", 
+		"Not", "AssignExp", "IntLit", "StrLit", "True", "False",
+	};
+	static_assert(sizeof(names) / sizeof(names[0]) 
+		== static_cast<size_t>(AstKind::KIND_COUNT), 
+		"every AstKind needs a name");
+	if (kind >= AstKind::KIND_COUNT){ return "Unknown"; }
+	return names[static_cast<size_t>(kind)];
+}
+
+uint32_t AstWriter::node(AstKind kind, ASTNode * node, 
+	uint32_t a, uint32_t b, uint32_t c, uint32_t d
+){
+	const Position * pos = node->pos();
+	records.push_back(AstRecord{kind, pos->startOffset(), 
+		pos->endOffset(), {a, b, c, d}});
+	return static_cast<uint32_t>(records.size() - 1);
+}
+
+uint32_t AstWriter::addList(const std::vector<uint32_t>& items){
+	uint32_t index = static_cast<uint32_t>(lists.size());
+	lists.push_back(static_cast<uint32_t>(items.size()));
+	lists.insert(lists.end(), items.begin(), items.end());
+	return index;
+}
+
+uint32_t AstWriter::string(const std::string& str){
+	auto found = stringIndex.find(str);
+	if (found != stringIndex.end()){ return found->second; }
+	uint32_t index = static_cast<uint32_t>(stringStarts.size());
+	stringStarts.push_back(static_cast<uint32_t>(blob.size()));
+	blob += str;
+	stringIndex[str] = index;
+	return index;
+}
+
+std::vector<size_t> AstWriter::kindCounts() const{
+	std::vector<size_t> counts(static_cast<size_t>(AstKind::KIND_COUNT), 0);
+	for (const AstRecord& rec : records){
+		counts[static_cast<size_t>(rec.kind)]++;
+	}
+	return counts;
+}
+
+template <typename T>
+static void writeArray(std::ostream& out, const std::vector<T>& items){
+	out.write(reinterpret_cast<const char *>(items.data()), 
+		static_cast<std::streamsize>(items.size() * sizeof(T)));
+}
+
+void AstWriter::write(std::ostream& out, LineTable * lines, 
+	bool resolved
+){
+	const std::vector<uint32_t>& lineStarts = lines->starts();
+	AstHeader header;
+	memcpy(header.magic, AST_MAGIC, sizeof(header.magic));
+	header.version = AstHeader::VERSION;
+	header.flags = resolved ? AstHeader::RESOLVED : 0;
+	header.nodeCount = static_cast<uint32_t>(records.size());
+	header.listWords = static_cast<uint32_t>(lists.size());
+	header.stringCount = static_cast<uint32_t>(stringStarts.size());
+	header.lineCount = static_cast<uint32_t>(lineStarts.size());
+	header.blobSize = static_cast<uint32_t>(blob.size());
+	header.sourceSize = static_cast<uint32_t>(lines->sourceSize());
+
+	std::vector<uint32_t> starts(stringStarts);
+	starts.push_back(header.blobSize);
+
+	out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	writeArray(out, records);
+	writeArray(out, lists);
+	writeArray(out, starts);
+	writeArray(out, lineStarts);
+	out.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+}
+
+void AstWriter::write(ProgramNode * ast, std::ostream& out, 
+	LineTable * lines, bool resolved
+){
+	AstWriter writer;
+	ast->serialize(&writer);
+	writer.write(out, lines, resolved);
+}
+
+//Where the sections of a .csast file are, once its header has
+// been checked against the size of the file
+struct AstSections{
+	const AstHeader * header;
+	const AstRecord * records;
+	const uint32_t * lists;
+	const uint32_t * stringStarts;
+	const uint32_t * lineStarts;
+	const char * blob;
+};
+
+static bool findSections(const SourceBuffer * file, AstSections * out){
+	const char * data = file->data();
+	size_t size = file->size();
+	if (!AstReader::matches(data, size)){ return false; }
+	//The sections are used in place, so the file must be at 
+	// least as aligned as its integers (mmapped files always are)
+	if (reinterpret_cast<uintptr_t>(data) % alignof(AstRecord) != 0){
+		return false;
+	}
+	const AstHeader * header = reinterpret_cast<const AstHeader *>(data);
+	if (header->version != AstHeader::VERSION){ return false; }
+
+	uint64_t need = sizeof(AstHeader) 
+		+ uint64_t(header->nodeCount) * sizeof(AstRecord)
+		+ (uint64_t(header->listWords) + header->stringCount + 1 
+			+ header->lineCount) * sizeof(uint32_t)
+		+ header->blobSize;
+	if (need != size){ return false; }
+
+	const char * cur = data + sizeof(AstHeader);
+	out->header = header;
+	out->records = reinterpret_cast<const AstRecord *>(cur);
+	cur += header->nodeCount * sizeof(AstRecord);
+	out->lists = reinterpret_cast<const uint32_t *>(cur);
+	cur += header->listWords * sizeof(uint32_t);
+	out->stringStarts = reinterpret_cast<const uint32_t *>(cur);
+	cur += (header->stringCount + 1) * sizeof(uint32_t);
+	out->lineStarts = reinterpret_cast<const uint32_t *>(cur);
+	cur += header->lineCount * sizeof(uint32_t);
+	out->blob = cur;
+	return true;
+}
+
+bool AstReader::matches(const char * data, size_t size){
+	return size >= sizeof(AstHeader) 
+		&& memcmp(data, AST_MAGIC, sizeof(AST_MAGIC)) == 0;
+}
+
+LineTable * AstReader::lineTable(const SourceBuffer * file){
+	AstSections sections;
+	if (!findSections(file, &sections)){ return nullptr; }
+	const AstHeader * header = sections.header;
+	std::vector<uint32_t> starts(sections.lineStarts, 
+		sections.lineStarts + header->lineCount);
+	if (starts.empty() || starts[0] != 0){ return nullptr; }
+	return new LineTable(std::move(starts), header->sourceSize);
+}
+
+namespace{
+
+//Builds the nodes of a .csast file in order. Since children
+// come before their parents, every operand that refers to a
+// node refers to one that has already been built; operands 
+// are checked (by index, kind and whether the node already has
+// a parent) before they are used, as are source offsets and 
+// symbol coords, so a malformed file can't produce a malformed
+// tree.
+class AstBuilder{
+public:
+	AstBuilder(const AstSections& sectionsIn)
+	: sections(sectionsIn), header(sectionsIn.header),
+	  nodes(header->nodeCount, nullptr), 
+	  kinds(header->nodeCount, AstKind::KIND_COUNT),
+	  used(header->nodeCount, false),
+	  ids(header->stringCount, NO_ID){ }
+
+	ProgramNode * build();
+private:
+	static const SymbolId NO_ID = UINT32_MAX;
+
+	[[noreturn]] void bad(){
+		throw new InternalError("Malformed .csast file");
+	}
+
+	//A node already built whose kind is in [first, last], and
+	// which isn't yet the child of another node: the tree must
+	// stay a tree
+	template <typename T>
+	T * child(size_t built, uint32_t index, AstKind first, AstKind last){
+		if (index >= built){ bad(); }
+		if (kinds[index] < first || kinds[index] > last){ bad(); }
+		if (used[index]){ bad(); }
+		used[index] = true;
+		return static_cast<T *>(nodes[index]);
+	}
+
+	template <typename T>
+	ArenaList<T *> * list(size_t built, uint32_t index, 
+		AstKind first, AstKind last
+	){
+		if (index >= header->listWords){ bad(); }
+		uint32_t count = sections.lists[index];
+		if (count > header->listWords - index - 1){ bad(); }
+		ArenaList<T *> * items = new ArenaList<T *>();
+		for (uint32_t i = 0; i < count; i++){
+			uint32_t item = sections.lists[index + 1 + i];
+			items->push_back(child<T>(built, item, first, last));
+		}
+		return items;
+	}
+
+	//A string in the file's blob, which lives as long as the
+	// file is loaded
+	SourceView view(uint32_t index){
+		if (index >= header->stringCount){ bad(); }
+		uint32_t start = sections.stringStarts[index];
+		uint32_t end = sections.stringStarts[index + 1];
+		if (start > end || end > header->blobSize){ bad(); }
+		return SourceView(sections.blob + start, end - start);
+	}
+
+	SymbolId id(uint32_t index){
+		if (index >= header->stringCount){ bad(); }
+		if (ids[index] == NO_ID){
+			SourceView name = view(index);
+			ids[index] = Interner::current()->intern(name.data(), 
+				name.length());
+		}
+		return ids[index];
+	}
+
+	//The span of a record, which must lie within the source 
+	// the AST was built from
+	Position position(const AstRecord& rec){
+		if (rec.start == Position::NONE && rec.end == Position::NONE){
+			return Position();
+		}
+		if (rec.start > rec.end || rec.end > header->sourceSize){ bad(); }
+		return Position(rec.start, rec.end);
+	}
+
+	//The coord of an ID, if it has one. Every scope and every
+	// slot needs a node to declare it, so neither can be as 
+	// large as the number of nodes.
+	SymbolCoord coord(uint32_t depth, uint32_t slot){
+		SymbolCoord unresolved;
+		if (depth == unresolved.depth && slot == unresolved.slot){
+			return unresolved;
+		}
+		if (depth >= header->nodeCount || slot >= header->nodeCount){ 
+			bad(); 
+		}
+		return SymbolCoord(depth, slot);
+	}
+
+	ASTNode * buildNode(size_t i, const AstRecord& rec);
+
+	const AstSections& sections;
+	const AstHeader * header;
+	std::vector<ASTNode *> nodes;
+	std::vector<AstKind> kinds;
+	//Whether each node has been made the child of another
+	std::vector<bool> used;
+	std::vector<SymbolId> ids;
+};
+
+const SymbolId AstBuilder::NO_ID;
+
+ProgramNode * AstBuilder::build(){
+	if (header->nodeCount == 0){ bad(); }
+	for (size_t i = 0; i < header->nodeCount; i++){
+		const AstRecord& rec = sections.records[i];
+		if (rec.kind >= AstKind::KIND_COUNT){ bad(); }
+		nodes[i] = buildNode(i, rec);
+		kinds[i] = rec.kind;
+	}
+	size_t root = header->nodeCount - 1;
+	if (kinds[root] != AstKind::PROGRAM){ bad(); }
+	return static_cast<ProgramNode *>(nodes[root]);
+}
+
+ASTNode * AstBuilder::buildNode(size_t i, const AstRecord& rec){
+	Position pos = position(rec);
+	Position * p = &pos;
+	const uint32_t * ops = rec.ops;
+	const AstKind TYPES = AstKind::VOID_TYPE;
+	const AstKind TYPES_END = AstKind::RECORD_TYPE;
+	const AstKind DECLS = AstKind::VAR_DECL;
+	const AstKind DECLS_END = AstKind::FN_DECL;
+	const AstKind STMTS_END = AstKind::CALL_STMT;
+	const AstKind EXPS = AstKind::ID;
+	const AstKind EXPS_END = AstKind::FALSE_LIT;
+	const AstKind ID = AstKind::ID;
+	const AstKind LVALS_END = AstKind::INDEX;
+
+	#define EXP(n) child<ExpNode>(i, ops[n], EXPS, EXPS_END)
+	#define LVAL(n) child<LValNode>(i, ops[n], ID, LVALS_END)
+	#define IDN(n) child<IDNode>(i, ops[n], ID, ID)
+	#define TYPE(n) child<TypeNode>(i, ops[n], TYPES, TYPES_END)
+	#define STMTS(n) list<StmtNode>(i, ops[n], DECLS, STMTS_END)
+	switch (rec.kind){
+	case AstKind::PROGRAM: {
+		ProgramNode * program = new ProgramNode(
+			list<DeclNode>(i, ops[0], DECLS, DECLS_END));
+		return program;
+	}
+	case AstKind::VOID_TYPE: return new VoidTypeNode(p);
+	case AstKind::INT_TYPE: return new IntTypeNode(p);
+	case AstKind::BOOL_TYPE: return new BoolTypeNode(p);
+	case AstKind::STRING_TYPE: return new StringTypeNode(p);
+	case AstKind::RECORD_TYPE: return new RecordTypeNode(p, IDN(0));
+	case AstKind::VAR_DECL: return new VarDeclNode(p, TYPE(0), IDN(1));
+	case AstKind::FORMAL_DECL: 
+		return new FormalDeclNode(p, TYPE(0), IDN(1));
+	case AstKind::RECORD_DECL:
+		return new RecordTypeDeclNode(p, IDN(0), list<VarDeclNode>(
+			i, ops[1], AstKind::VAR_DECL, AstKind::VAR_DECL));
+	case AstKind::FN_DECL:
+		return new FnDeclNode(p, TYPE(0), IDN(1), list<FormalDeclNode>(
+			i, ops[2], AstKind::FORMAL_DECL, AstKind::FORMAL_DECL),
+			STMTS(3));
+	case AstKind::ASSIGN_STMT:
+		return new AssignStmtNode(p, child<AssignExpNode>(i, ops[0], 
+			AstKind::ASSIGN_EXP, AstKind::ASSIGN_EXP));
+	case AstKind::RECEIVE_STMT: return new ReceiveStmtNode(p, LVAL(0));
+	case AstKind::REPORT_STMT: return new ReportStmtNode(p, EXP(0));
+	case AstKind::POST_DEC_STMT: return new PostDecStmtNode(p, LVAL(0));
+	case AstKind::POST_INC_STMT: return new PostIncStmtNode(p, LVAL(0));
+	case AstKind::IF_STMT: return new IfStmtNode(p, EXP(0), STMTS(1));
+	case AstKind::IF_ELSE_STMT: 
+		return new IfElseStmtNode(p, EXP(0), STMTS(1), STMTS(2));
+	case AstKind::WHILE_STMT: 
+		return new WhileStmtNode(p, EXP(0), STMTS(1));
+	case AstKind::RETURN_STMT:
+		if (ops[0] == AstRecord::NONE){ 
+			return new ReturnStmtNode(p, nullptr);
+		}
+		return new ReturnStmtNode(p, EXP(0));
+	case AstKind::CALL_STMT:
+		return new CallStmtNode(p, child<CallExpNode>(i, ops[0], 
+			AstKind::CALL_EXP, AstKind::CALL_EXP));
+	case AstKind::ID: {
+		IDNode * node = new IDNode(p, id(ops[0]));
+		if (header->flags & AstHeader::RESOLVED){
+			node->setCoord(coord(ops[1], ops[2]));
+		}
+		return node;
+	}
+	case AstKind::INDEX: return new IndexNode(p, IDN(0), IDN(1));
+	case AstKind::CALL_EXP:
+		return new CallExpNode(p, IDN(0), 
+			list<ExpNode>(i, ops[1], EXPS, EXPS_END));
+	case AstKind::PLUS: return new PlusNode(p, EXP(0), EXP(1));
+	case AstKind::MINUS: return new MinusNode(p, EXP(0), EXP(1));
+	case AstKind::TIMES: return new TimesNode(p, EXP(0), EXP(1));
+	case AstKind::DIVIDE: return new DivideNode(p, EXP(0), EXP(1));
+	case AstKind::AND: return new AndNode(p, EXP(0), EXP(1));
+	case AstKind::OR: return new OrNode(p, EXP(0), EXP(1));
+	case AstKind::EQUALS: return new EqualsNode(p, EXP(0), EXP(1));
+	case AstKind::NOT_EQUALS: return new NotEqualsNode(p, EXP(0), EXP(1));
+	case AstKind::LESS: return new LessNode(p, EXP(0), EXP(1));
+	case AstKind::LESS_EQ: return new LessEqNode(p, EXP(0), EXP(1));
+	case AstKind::GREATER: return new GreaterNode(p, EXP(0), EXP(1));
+	case AstKind::GREATER_EQ: return new GreaterEqNode(p, EXP(0), EXP(1));
+	case AstKind::NEG: return new NegNode(p, EXP(0));
+	case AstKind::NOT: return new NotNode(p, EXP(0));
+	case AstKind::ASSIGN_EXP: return new AssignExpNode(p, LVAL(0), EXP(1));
+	case AstKind::INT_LIT: 
+		return new IntLitNode(p, static_cast<int>(ops[0]));
+	case AstKind::STR_LIT: return new StrLitNode(p, view(ops[0]));
+	case AstKind::TRUE_LIT: return new TrueNode(p);
+	case AstKind::FALSE_LIT: return new FalseNode(p);
+	case AstKind::KIND_COUNT: break;
+	}
+	#undef EXP
+	#undef LVAL
+	#undef IDN
+	#undef TYPE
+	#undef STMTS
+	bad();
+}
+
+} //End anonymous namespace
+
+ProgramNode * AstReader::load(const SourceBuffer * file){
+	AstSections sections;
+	if (!findSections(file, &sections)){
+		throw new InternalError("Malformed .csast file");
+	}
+	AstBuilder builder(sections);
+	return builder.build();
+}
+
+} //End namespace cshanty
@@ -0,0 +1,145 @@
+#ifndef CSHANTY_AST_FILE_HPP
+#define CSHANTY_AST_FILE_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+#include "position.hpp"
+#include "source_buffer.hpp"
+
+//The .csast format: an AST written out in flat sections, so 
+// that it can be mapped back into memory and rebuilt in one 
+// pass without lexing or parsing. The file is
+//   AstHeader
+//   AstRecord[nodeCount]       each node, children before parents
+//   uint32_t[listWords]        each list: count, then node indices
+//   uint32_t[stringCount + 1]  start of each string in the blob
+//   uint32_t[lineCount]        start offset of each source line
+//   char[blobSize]             the text of every string
+// All integers are in the writer's (little-endian) byte order.
+
+namespace cshanty{
+
+class ASTNode;
+class ProgramNode;
+
+//One kind per concrete AST class. Kinds of the same category 
+// are kept together so that the reader can check the kind of 
+// each child with a range test.
+enum class AstKind : uint32_t{
+	PROGRAM,
+	VOID_TYPE, INT_TYPE, BOOL_TYPE, STRING_TYPE, RECORD_TYPE,
+	VAR_DECL, FORMAL_DECL, RECORD_DECL, FN_DECL,
+	ASSIGN_STMT, RECEIVE_STMT, REPORT_STMT, POST_DEC_STMT, 
+	POST_INC_STMT, IF_STMT, IF_ELSE_STMT, WHILE_STMT, RETURN_STMT,
+	CALL_STMT,
+	ID, INDEX, CALL_EXP, 
+	PLUS, MINUS, TIMES, DIVIDE, AND, OR, EQUALS, NOT_EQUALS, 
+	LESS, LESS_EQ, GREATER, GREATER_EQ, NEG, NOT, 
+	ASSIGN_EXP, INT_LIT, STR_LIT, TRUE_LIT, FALSE_LIT,
+	KIND_COUNT
+};
+
+//The name of a kind, as it appears in --stats output
+const char * astKindName(AstKind kind);
+
+struct AstHeader{
+	static const uint32_t VERSION = 1;
+	//Set if the AST was written after name analysis, in which
+	// case IDs of variables carry their SymbolCoord
+	static const uint32_t RESOLVED = 1;
+
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+	uint32_t nodeCount;
+	uint32_t listWords;
+	uint32_t stringCount;
+	uint32_t lineCount;
+	uint32_t blobSize;
+	uint32_t sourceSize;
+};
+
+//A node: its kind, source span and up to 4 operands, which are
+// node indices, list indices, string indices or values 
+// depending on the kind
+struct AstRecord{
+	static const uint32_t NONE = UINT32_MAX;
+
+	AstKind kind;
+	uint32_t start;
+	uint32_t end;
+	uint32_t ops[4];
+};
+
+//Collects the nodes of an AST, as each node's serialize 
+// function hands them over, and writes them out as a .csast
+class AstWriter{
+public:
+	//Add a node (whose children have already been added) and
+	// return its index
+	uint32_t node(AstKind kind, ASTNode * node, 
+		uint32_t a = AstRecord::NONE, uint32_t b = AstRecord::NONE,
+		uint32_t c = AstRecord::NONE, uint32_t d = AstRecord::NONE);
+
+	//Add the nodes of a list, then the list itself, and return
+	// the list's index
+	template <typename T>
+	uint32_t list(ArenaList<T *> * items);
+
+	//The index of a string, added if it is new
+	uint32_t string(const std::string& str);
+
+	//The number of nodes of each kind added so far, indexed
+	// by AstKind
+	std::vector<size_t> kindCounts() const;
+
+	//Write out the file for an AST whose nodes have all been 
+	// added. lines is the line table of its source.
+	void write(std::ostream& out, LineTable * lines, bool resolved);
+
+	//Serialize the AST and write the file
+	static void write(ProgramNode * ast, std::ostream& out, 
+		LineTable * lines, bool resolved);
+private:
+	uint32_t addList(const std::vector<uint32_t>& items);
+
+	std::vector<AstRecord> records;
+	std::vector<uint32_t> lists;
+	std::vector<uint32_t> stringStarts;
+	std::string blob;
+	std::unordered_map<std::string, uint32_t> stringIndex;
+};
+
+//Rebuilds the AST in a .csast file, which is used in place
+// (e.g. straight out of an mmapped SourceBuffer)
+class AstReader{
+public:
+	//Whether the data is a .csast file (rather than source)
+	static bool matches(const char * data, size_t size);
+
+	//The line table of the source the AST was built from, or
+	// nullptr if the file is malformed
+	static LineTable * lineTable(const SourceBuffer * file);
+
+	//Build the AST in the current arena. Throws InternalError
+	// if the file is malformed.
+	static ProgramNode * load(const SourceBuffer * file);
+};
+
+template <typename T>
+uint32_t AstWriter::list(ArenaList<T *> * items){
+	std::vector<uint32_t> indices;
+	indices.reserve(items->size());
+	for (auto item : *items){
+		indices.push_back(item->serialize(this));
+	}
+	return addList(indices);
+}
+
+} //End namespace cshanty
+
+#endif
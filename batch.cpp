@@ -0,0 +1,100 @@
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "batch.hpp"
+#include "errors.hpp"
+
+namespace cshanty{
+
+void Batch::compileFile(size_t index, CompileFn& compile, Result * result){
+	std::ostringstream out;
+	std::ostringstream err;
+	Report::Scope report(&err, &out);
+
+	CompilationSession session(paths[index].c_str());
+	if (!session.good()){
+		err << "Bad path " << paths[index] << std::endl;
+		result->exitCode = 1;
+		result->lines = 0;
+	} else {
+		CompilationSession::Activation active(&session);
+		result->exitCode = compile(&session);
+		result->lines = session.lineCount();
+	}
+	result->out = out.str();
+	result->err = err.str();
+}
+
+int Batch::run(CompileFn compile, std::ostream& out, std::ostream& err){
+	std::vector<Result> results(paths.size());
+	std::atomic<size_t> nextFile(0);
+
+	//Workers take the next file to compile until there are
+	// none left, so a few big files don't hold up the rest
+	auto work = [&](){
+		while (true){
+			size_t index = nextFile++;
+			if (index >= paths.size()){ return; }
+			compileFile(index, compile, &results[index]);
+		}
+	};
+
+	std::chrono::steady_clock::time_point start = 
+		std::chrono::steady_clock::now();
+	size_t workers = jobs < paths.size() ? jobs : paths.size();
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < workers; i++){
+		pool.emplace_back(work);
+	}
+	work();
+	for (auto& worker : pool){
+		worker.join();
+	}
+	std::chrono::duration<double> elapsed = 
+		std::chrono::steady_clock::now() - start;
+	seconds = elapsed.count();
+
+	failed = 0;
+	lines = 0;
+	for (size_t i = 0; i < results.size(); i++){
+		const Result& result = results[i];
+		if (!result.err.empty()){
+			err << "== " << paths[i] << " ==\n" << result.err;
+		}
+		if (!result.out.empty()){
+			out << "== " << paths[i] << " ==\n" << result.out;
+		}
+		if (result.exitCode != 0){ failed++; }
+		lines += result.lines;
+	}
+	out.flush();
+	return failed == 0 ? 0 : 1;
+}
+
+void Batch::summary(std::ostream& out) const{
+	double rateBase = seconds > 0 ? seconds : 1e-9;
+	out << paths.size() << " files (" << failed << " failed), "
+	  << lines << " lines in " << seconds << "s: "
+	  << static_cast<double>(paths.size()) / rateBase << " files/s, "
+	  << static_cast<double>(lines) / rateBase << " lines/s"
+	  << std::endl;
+}
+
+bool Batch::readFileList(const char * listPath, 
+	std::vector<std::string> * pathsOut
+){
+	std::ifstream list(listPath);
+	if (!list.good()){ return false; }
+	std::string line;
+	while (std::getline(list, line)){
+		size_t first = line.find_first_not_of(" \t\r");
+		if (first == std::string::npos){ continue; }
+		size_t last = line.find_last_not_of(" \t\r");
+		pathsOut->push_back(line.substr(first, last - first + 1));
+	}
+	return true;
+}
+
+} //End namespace cshanty
@@ -0,0 +1,56 @@
+#ifndef CSHANTY_BATCH_HPP
+#define CSHANTY_BATCH_HPP
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "session.hpp"
+
+namespace cshanty{
+
+//Compiles a list of input files in one process, spreading them
+// over a pool of worker threads. Each file gets its own 
+// CompilationSession, and everything reported while compiling 
+// it is captured and written out after all files are done, in
+// the order the files were given, so the output does not depend
+// on how the work was scheduled.
+class Batch{
+public:
+	//Compiles one (activated) session and returns its exit code
+	using CompileFn = std::function<int(CompilationSession *)>;
+
+	Batch(const std::vector<std::string>& pathsIn, size_t jobsIn)
+	: paths(pathsIn), jobs(jobsIn), failed(0), lines(0), seconds(0){ }
+
+	//Compile every file, write out each file's diagnostics and 
+	// output, and return 0 if every file compiled successfully
+	int run(CompileFn compile, std::ostream& out, std::ostream& err);
+
+	//Write the number of files compiled, and the rate at which 
+	// files and lines were compiled
+	void summary(std::ostream& out) const;
+
+	//Add the paths listed (one per line) in a file to paths. 
+	// Returns false if the file cannot be read.
+	static bool readFileList(const char * listPath, 
+		std::vector<std::string> * paths);
+private:
+	struct Result{
+		int exitCode;
+		size_t lines;
+		std::string out;
+		std::string err;
+	};
+	void compileFile(size_t index, CompileFn& compile, Result * result);
+
+	std::vector<std::string> paths;
+	size_t jobs;
+	size_t failed;
+	size_t lines;
+	double seconds;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,116 @@
+//Checks that loading a malformed .csast file is refused with an
+// InternalError instead of building a malformed tree. Starting
+// from the resolved .csast of a small program (which must load),
+// each case changes one record:
+//   shared:  a node made the child of two operands, so the AST
+//            would be a DAG
+//   coord:   an ID whose SymbolCoord is out of range
+//   offsets: a node whose span ends past the end of the source
+//   reversed: a node whose span starts after it ends
+// Run as
+//   bench/ast_file_test
+// and exits with 1 if any case loads.
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "ast_file.hpp"
+#include "errors.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+const char * const PROGRAM =
+	"int g;\n"
+	"int f(int a){\n"
+	"\treturn a + g;\n"
+	"}\n";
+
+struct Case{
+	const char * name;
+	//Change the first record of the given kind
+	AstKind kind;
+	std::function<void(AstRecord *)> change;
+};
+
+size_t recordOffset(size_t i){
+	return sizeof(AstHeader) + i * sizeof(AstRecord);
+}
+
+//Change the first record of a kind, returning false if there
+// is no such record
+bool changeRecord(std::string * file, const Case& c){
+	AstHeader header;
+	memcpy(&header, file->data(), sizeof(header));
+	for (size_t i = 0; i < header.nodeCount; i++){
+		AstRecord rec;
+		memcpy(&rec, file->data() + recordOffset(i), sizeof(rec));
+		if (rec.kind != c.kind){ continue; }
+		c.change(&rec);
+		memcpy(&(*file)[recordOffset(i)], &rec, sizeof(rec));
+		return true;
+	}
+	return false;
+}
+
+//Whether the file loads, or is refused as malformed
+bool loads(const std::string& file){
+	CompilationSession session("malformed.csast",
+		SourceBuffer::fromString(file));
+	try {
+		return session.ast() != nullptr;
+	} catch (InternalError * e){
+		delete e;
+		return false;
+	}
+}
+
+}
+
+int main(){
+	std::string file;
+	{
+		CompilationSession session("valid",
+			SourceBuffer::fromString(PROGRAM));
+		if (session.nameAnalysis() == nullptr){
+			std::cerr << "Name analysis failed\n";
+			return 1;
+		}
+		std::ostringstream out;
+		session.writeAST(out);
+		file = out.str();
+	}
+	if (!loads(file)){
+		std::cout << "FAIL: the valid .csast doesn't load\n";
+		return 1;
+	}
+
+	uint32_t sourceSize = static_cast<uint32_t>(strlen(PROGRAM));
+	const Case cases[] = {
+		{"shared", AstKind::PLUS,
+			[](AstRecord * rec){ rec->ops[1] = rec->ops[0]; }},
+		{"coord", AstKind::ID,
+			[](AstRecord * rec){ rec->ops[2] = UINT32_MAX - 1; }},
+		{"offsets", AstKind::ID,
+			[sourceSize](AstRecord * rec){ rec->end = sourceSize + 1; }},
+		{"reversed", AstKind::ID,
+			[](AstRecord * rec){ rec->start = rec->end + 1; }},
+	};
+	int status = 0;
+	for (const Case& c : cases){
+		std::string bad = file;
+		if (!changeRecord(&bad, c)){
+			std::cout << c.name << ": no record to change\n";
+			status = 1;
+		} else if (loads(bad)){
+			std::cout << c.name << ": malformed file loaded\n";
+			status = 1;
+		}
+	}
+	if (status != 0){ std::cout << "FAIL: malformed .csast accepted\n"; }
+	return status;
+}
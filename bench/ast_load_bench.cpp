@@ -0,0 +1,87 @@
+//Times loading a saved .csast against lexing and parsing the
+// source it was saved from. Run as
+//   bench/ast_load_bench [functions] [rounds]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "program_gen.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start){
+	std::chrono::duration<double, std::milli> elapsed = 
+		Clock::now() - start;
+	return elapsed.count();
+}
+
+//The time to build the AST of the text, and its unparse
+double timeAST(const std::string& text, std::string * unparsed){
+	CompilationSession session("bench", SourceBuffer::fromString(text));
+	Clock::time_point start = Clock::now();
+	ProgramNode * root = session.ast();
+	double ms = msSince(start);
+	if (root == nullptr){
+		std::cerr << "No AST built\n";
+		exit(1);
+	}
+	if (unparsed != nullptr){
+		CompilationSession::Activation active(&session);
+		std::ostringstream out;
+		root->unparse(out, 0);
+		*unparsed = out.str();
+	}
+	return ms;
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t fns = 20000;
+	size_t rounds = 5;
+	if (argc > 1){ fns = std::strtoul(argv[1], nullptr, 10); }
+	if (argc > 2){ rounds = std::strtoul(argv[2], nullptr, 10); }
+
+	ProgramShape shape;
+	shape.fns = fns;
+	std::string source = generateProgram(shape);
+	std::string saved;
+	{
+		CompilationSession session("bench", 
+			SourceBuffer::fromString(source));
+		std::ostringstream out;
+		session.writeAST(out);
+		saved = out.str();
+	}
+
+	std::string fromSource;
+	std::string fromSaved;
+	timeAST(source, &fromSource);
+	timeAST(saved, &fromSaved);
+	if (fromSource != fromSaved){
+		std::cerr << "Loaded AST differs from parsed AST\n";
+		return 1;
+	}
+
+	double parseMs = 0;
+	double loadMs = 0;
+	for (size_t r = 0; r < rounds; r++){
+		parseMs += timeAST(source, nullptr);
+		loadMs += timeAST(saved, nullptr);
+	}
+
+	std::cout << fns << " functions, " << source.size() 
+	  << " source bytes, " << saved.size() << " .csast bytes, " 
+	  << rounds << " rounds\n"
+	  << "  lex+parse: " << parseMs / rounds << " ms/round\n"
+	  << "  load:      " << loadMs / rounds << " ms/round ("
+	  << parseMs / loadMs << "x faster)\n";
+	return 0;
+}
@@ -0,0 +1,132 @@
+//Checks that compiling input after input in one process, as
+// batch mode and the compile server do, doesn't make the
+// process grow: each CompilationSession must free everything
+// it built. A batch of inputs (a generated program, one with
+// long string literals, and two that fail name and type 
+// analysis) is compiled through every phase, round after 
+// round. Once the first WARM_ROUNDS have warmed up the 
+// allocator (each worker thread gets its own malloc arena),
+// the resident set may not grow by more than MAX_GROWTH_KB.
+// Run as
+//   bench/batch_memory_test [rounds]
+// and exits with 1 if it grows.
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "batch.hpp"
+#include "driver.hpp"
+#include "program_gen.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+//Sessions that leaked their analyses grew the process by about
+// 1.6 MB a round; the allocator alone can move it by about 1 MB
+const size_t MAX_GROWTH_KB = 4096;
+const size_t WARM_ROUNDS = 2;
+//Copies of each input per batch
+const size_t COPIES = 8;
+
+const char * const STRINGS =
+	"void main(){\n"
+	"\treport \"a string literal much too long to fit inline\";\n"
+	"\treport \"and another, so that each one is allocated\";\n"
+	"}\n";
+
+const char * const BAD_NAMES =
+	"int f(int a){\n"
+	"\treturn b;\n"
+	"}\n";
+
+const char * const BAD_TYPES =
+	"int f(int a, bool c){\n"
+	"\treport \"the wrong number of args is an error\";\n"
+	"\treturn f(1) + true;\n"
+	"}\n";
+
+size_t residentKB(){
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0;
+	size_t resident = 0;
+	statm >> pages >> resident;
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+}
+
+std::string writeInput(const std::string& dir, const char * name,
+	const std::string& text
+){
+	std::string path = dir + "/" + name;
+	std::ofstream out(path);
+	out << text;
+	return path;
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t rounds = 10;
+	if (argc > 1){ rounds = std::strtoul(argv[1], nullptr, 10); }
+	if (rounds <= WARM_ROUNDS){
+		std::cerr << "Usage: batch_memory_test [rounds > " 
+		  << WARM_ROUNDS << "]\n";
+		return 1;
+	}
+
+	char dirTemplate[] = "/tmp/cshanty_memXXXXXX";
+	if (mkdtemp(dirTemplate) == nullptr){
+		std::cerr << "Can't make a temporary directory\n";
+		return 1;
+	}
+	std::string dir = dirTemplate;
+	std::vector<std::string> inputs;
+	inputs.push_back(writeInput(dir, "gen.cshanty",
+		generateProgram(ProgramShape())));
+	inputs.push_back(writeInput(dir, "strings.cshanty", STRINGS));
+	inputs.push_back(writeInput(dir, "names.cshanty", BAD_NAMES));
+	inputs.push_back(writeInput(dir, "types.cshanty", BAD_TYPES));
+	std::vector<std::string> paths;
+	for (size_t i = 0; i < COPIES; i++){
+		paths.insert(paths.end(), inputs.begin(), inputs.end());
+	}
+
+	//Every phase, with each output captured by the batch
+	Options opts;
+	opts.tokensFile = "--";
+	opts.unparseFile = "--";
+	opts.namesFile = "--";
+	opts.checkTypes = true;
+	opts.jobs = 2;
+	auto compileOne = [&](CompilationSession * session){
+		return compile(session, opts);
+	};
+
+	size_t warm = 0;
+	size_t last = 0;
+	for (size_t r = 0; r < rounds; r++){
+		std::ostringstream out;
+		std::ostringstream err;
+		Batch batch(paths, opts.jobs);
+		batch.run(compileOne, out, err);
+		last = residentKB();
+		if (r + 1 == WARM_ROUNDS){ warm = last; }
+	}
+	for (const std::string& input : inputs){
+		std::remove(input.c_str());
+	}
+	rmdir(dir.c_str());
+
+	size_t growth = last > warm ? last - warm : 0;
+	std::cout << "resident after round " << WARM_ROUNDS << ": " << warm 
+	  << " KB, after round " << rounds << ": " << last << " KB (grew " << growth << " KB)\n";
+	if (growth > MAX_GROWTH_KB){
+		std::cout << "FAIL: compiling sessions leaks memory\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,112 @@
+//Checks the SymbolCoord that name analysis gives each variable
+// declaration: globals and locals get slots in their own
+// numbering, and a record's fields get their index in the
+// record rather than a slot among the globals. The coords are
+// read back out of the resolved .csast of a small program.
+// Run as
+//   bench/coord_test
+// and exits with 1 if any coord is wrong.
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ast_file.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+#include "symbol_coord.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+const char * const PROGRAM =
+	"int g;\n"
+	"record Point {\n"
+	"\tint x;\n"
+	"\tbool y;\n"
+	"}\n"
+	"Point origin;\n"
+	"void f(int a){\n"
+	"\tint b;\n"
+	"\tb = a;\n"
+	"}\n";
+
+struct Expected{
+	const char * name;
+	uint32_t depth;
+	uint32_t slot;
+};
+
+//The declaring ID of each name (the first one in the file,
+// since children come before parents and declarations come
+// before uses)
+const Expected EXPECTED[] = {
+	{"g", SymbolCoord::GLOBAL_DEPTH, 0},
+	{"x", SymbolCoord::FIELD_DEPTH, 0},
+	{"y", SymbolCoord::FIELD_DEPTH, 1},
+	{"origin", SymbolCoord::GLOBAL_DEPTH, 1},
+	{"a", SymbolCoord::GLOBAL_DEPTH + 1, 0},
+	{"b", SymbolCoord::GLOBAL_DEPTH + 1, 1},
+};
+
+template <typename T>
+T readAt(const std::string& file, size_t offset){
+	T value;
+	memcpy(&value, file.data() + offset, sizeof(T));
+	return value;
+}
+
+}
+
+int main(){
+	std::string file;
+	{
+		CompilationSession session("coords",
+			SourceBuffer::fromString(PROGRAM));
+		if (session.nameAnalysis() == nullptr){
+			std::cerr << "Name analysis failed\n";
+			return 1;
+		}
+		std::ostringstream out;
+		session.writeAST(out);
+		file = out.str();
+	}
+
+	AstHeader header = readAt<AstHeader>(file, 0);
+	size_t records = sizeof(AstHeader);
+	size_t starts = records + header.nodeCount * sizeof(AstRecord)
+		+ header.listWords * sizeof(uint32_t);
+	size_t blob = starts + (header.stringCount + 1) * sizeof(uint32_t)
+		+ header.lineCount * sizeof(uint32_t);
+
+	int status = 0;
+	for (const Expected& want : EXPECTED){
+		bool found = false;
+		for (size_t i = 0; i < header.nodeCount && !found; i++){
+			AstRecord rec = readAt<AstRecord>(file,
+				records + i * sizeof(AstRecord));
+			if (rec.kind != AstKind::ID){ continue; }
+			uint32_t start = readAt<uint32_t>(file,
+				starts + rec.ops[0] * sizeof(uint32_t));
+			uint32_t end = readAt<uint32_t>(file,
+				starts + (rec.ops[0] + 1) * sizeof(uint32_t));
+			if (file.compare(blob + start, end - start, want.name) != 0){
+				continue;
+			}
+			found = true;
+			if (rec.ops[1] != want.depth || rec.ops[2] != want.slot){
+				std::cout << want.name << ": coord (" << rec.ops[1]
+				  << ", " << rec.ops[2] << "), expected (" << want.depth
+				  << ", " << want.slot << ")\n";
+				status = 1;
+			}
+		}
+		if (!found){
+			std::cout << want.name << ": no ID in the .csast\n";
+			status = 1;
+		}
+	}
+	if (status != 0){ std::cout << "FAIL: wrong symbol coords\n"; }
+	return status;
+}
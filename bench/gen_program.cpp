@@ -0,0 +1,44 @@
+//Writes a generated cshanty program to stdout. Run as
+//   bench/gen_program [-f fns] [-r records] [-g globals] 
+//     [-d depth] [-c chain] [-x fields] [-s siblings] 
+//     [-a params] [-p]
+// (-p uses the pirate keyword synonyms; see ProgramShape)
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "program_gen.hpp"
+
+using namespace cshanty;
+
+int main(int argc, char ** argv){
+	ProgramShape shape;
+	for (int i = 1; i < argc; i++){
+		const char * arg = argv[i];
+		if (strcmp(arg, "-p") == 0){
+			shape.pirate = true;
+			continue;
+		}
+		if (arg[0] != '-' || i + 1 >= argc){
+			std::cerr << "Usage: gen_program [-f fns] [-r records]"
+			  << " [-g globals] [-d depth] [-c chain] [-x fields]"
+			  << " [-s siblings] [-a params] [-p]\n";
+			return 1;
+		}
+		size_t value = std::strtoul(argv[++i], nullptr, 10);
+		switch (arg[1]){
+		case 'f': shape.fns = value; break;
+		case 'r': shape.records = value; break;
+		case 'g': shape.globals = value; break;
+		case 'd': shape.depth = value; break;
+		case 'c': shape.chain = value; break;
+		case 'x': shape.fields = value; break;
+		case 's': shape.siblings = value; break;
+		case 'a': shape.params = value; break;
+		default:
+			std::cerr << "Unrecognized argument: " << arg << "\n";
+			return 1;
+		}
+	}
+	std::cout << generateProgram(shape);
+	return 0;
+}
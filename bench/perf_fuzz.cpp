@@ -0,0 +1,362 @@
+//An in-process fuzzer that looks for inputs on which the
+// compiler does super-linear work, rather than for crashes.
+// Each input is lexed, parsed, name analyzed and type analyzed
+// in a fresh session, and scored by the work done per input
+// byte beyond that of an empty input: heap and arena
+// allocations by default, or thread CPU time with -t. Since a
+// linear pipeline scores about the same at any size, mutations
+// that grow an input (like repeating part of it) only pay off
+// when some phase is super-linear in what was repeated. The
+// dictionary leans on the scanner's bad string escape rules
+// and on tokens that drive the parser into its error paths.
+// Run as
+//   bench/perf_fuzz [-n runs] [-l maxLen] [-s seed] [-t]
+//                   [-o corpusDir] [seedFile...]
+// to fuzz from the seed files (or from nothing), saving the
+// worst inputs found to corpusDir (default bench/perf_corpus)
+// as a regression corpus, or as
+//   bench/perf_fuzz -r [-t] [-x maxScore] file...
+// to print the score of each saved input, failing if any is
+// above maxScore. Any input that raises an InternalError is
+// saved as well, as crash-<n>.cshanty. make test replays the
+// committed bench/perf_corpus this way.
+//
+//Compiled with -DCSHANTY_LIBFUZZER and clang's
+// -fsanitize=fuzzer instead, this file provides libFuzzer's
+// entry point, which aborts (so that libFuzzer keeps the input)
+// when an input's score is above CSHANTY_FUZZ_MAX_SCORE.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include "errors.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+#include "stats.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+struct Cost{
+	size_t allocations;
+	double cpuMs;
+	bool internalError;
+};
+
+double threadCpuMs(){
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return static_cast<double>(now.tv_sec) * 1e3
+		+ static_cast<double>(now.tv_nsec) / 1e6;
+}
+
+Cost measure(const std::string& input){
+	Cost cost{0, 0, false};
+	std::ostringstream discard;
+	Report::Scope quiet(&discard, &discard);
+	//Heap allocations are counted by stats.cpp's operator new,
+	// per thread (the fuzzer only ever compiles on one)
+	size_t heapBefore = threadHeapUse().allocations;
+	double cpuBefore = threadCpuMs();
+	{
+		CompilationSession session("fuzz", SourceBuffer::fromString(input));
+		try {
+			session.typeAnalysis();
+		} catch (InternalError * e){
+			cost.internalError = true;
+			delete e;
+		} catch (ToDoError * e){
+			cost.internalError = true;
+			delete e;
+		}
+		cost.allocations = session.arena().allocations();
+	}
+	cost.allocations += threadHeapUse().allocations - heapBefore;
+	cost.cpuMs = threadCpuMs() - cpuBefore;
+	return cost;
+}
+
+//Work done beyond that of an empty input, per input byte
+class Scorer{
+public:
+	Scorer(bool cpuIn) : cpu(cpuIn), baseline(measure("")){ }
+	double score(const Cost& cost, size_t len) const{
+		double extra = cpu ? cost.cpuMs - baseline.cpuMs
+			: static_cast<double>(cost.allocations)
+			  - static_cast<double>(baseline.allocations);
+		return extra / static_cast<double>(std::max<size_t>(len, 1));
+	}
+	const char * unit() const {
+		return cpu ? "cpu ms/byte" : "allocations/byte";
+	}
+private:
+	bool cpu;
+	Cost baseline;
+};
+
+const char * const DICTIONARY[] = {
+	//String literals, including each kind of bad escape
+	"\"", "\\", "\\q", "\\n", "\\\"", "\"\\", "\"a\\q", "\\\\",
+	"\n", " ", "//", "0", "99999999999",
+	//Keywords and their pirate synonyms
+	"int", "bool", "string", "void", "record", "if", "else",
+	"while", "return", "report", "true", "false", "aye", "nay",
+	"ahoy", "shove off", "heave and go", "roll and go", "gets",
+	"we'll take our leave and go", "plus", "minus", "times",
+	"divide", "and", "or", "equals",
+	//Punctuation, which unbalanced sends the parser to its
+	// error paths
+	"{", "}", "(", ")", "[", "]", ";", ",", ".", "=", "==",
+	"!=", "++", "--", "!", "+", "-", "*", "/", "<", ">=",
+	"&&", "||",
+	"a", "f", "r",
+};
+const size_t DICTIONARY_SIZE = sizeof(DICTIONARY) / sizeof(DICTIONARY[0]);
+
+class Mutator{
+public:
+	Mutator(unsigned seed, size_t maxLenIn)
+	: rng(seed), maxLen(maxLenIn){ }
+
+	std::string mutate(const std::string& input,
+		const std::string& other){
+		std::string out = input;
+		size_t edits = 1 + below(4);
+		for (size_t i = 0; i < edits; i++){ mutateOnce(&out, other); }
+		if (out.size() > maxLen){ out.resize(maxLen); }
+		return out;
+	}
+	size_t below(size_t n){
+		return std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+	}
+private:
+	void mutateOnce(std::string * s, const std::string& other){
+		size_t at = below(s->size() + 1);
+		switch (below(6)){
+		case 0: //Insert a dictionary token
+			s->insert(at, DICTIONARY[below(DICTIONARY_SIZE)]);
+			break;
+		case 1: //Overwrite a byte
+			if (!s->empty()){
+				(*s)[below(s->size())] = static_cast<char>(below(128));
+			}
+			break;
+		case 2: //Remove a range
+			if (!s->empty()){
+				s->erase(at == s->size() ? at - 1 : at, 1 + below(8));
+			}
+			break;
+		case 3: //Repeat a range, which grows whatever is expensive
+		case 4: {
+			if (s->empty()){ break; }
+			size_t start = below(s->size());
+			size_t len = 1 + below(std::min<size_t>(s->size() - start, 64));
+			std::string chunk = s->substr(start, len);
+			size_t times = 1 + below(16);
+			for (size_t k = 0; k < times; k++){ s->insert(start, chunk); }
+			break;
+		}
+		default: //Splice in part of another input
+			if (!other.empty()){
+				size_t start = below(other.size());
+				s->insert(at, other, start, 1 + below(other.size() - start));
+			}
+			break;
+		}
+	}
+
+	std::mt19937 rng;
+	size_t maxLen;
+};
+
+struct Entry{
+	std::string input;
+	double score;
+};
+
+bool readFile(const char * path, std::string * out){
+	std::ifstream in(path, std::ios::binary);
+	if (!in){ return false; }
+	std::ostringstream text;
+	text << in.rdbuf();
+	*out = text.str();
+	return true;
+}
+
+bool writeFile(const std::string& path, const std::string& text){
+	std::ofstream out(path, std::ios::binary);
+	out << text;
+	return static_cast<bool>(out);
+}
+
+void usageAndDie(){
+	std::cerr << "Usage: perf_fuzz [-n runs] [-l maxLen] [-s seed] [-t]"
+	  " [-o corpusDir] [seedFile...]\n"
+	  "       perf_fuzz -r [-t] [-x maxScore] file...\n";
+	exit(1);
+}
+
+int replay(const std::vector<std::string>& files, bool cpu,
+	double maxScore){
+	Scorer scorer(cpu);
+	bool passed = true;
+	std::cout << std::fixed << std::setprecision(3);
+	for (const std::string& file : files){
+		std::string input;
+		if (!readFile(file.c_str(), &input)){
+			std::cerr << "Could not read " << file << "\n";
+			return 1;
+		}
+		Cost cost = measure(input);
+		double score = scorer.score(cost, input.size());
+		bool failed = cost.internalError || score > maxScore;
+		passed = passed && !failed;
+		std::cout << file << ": " << input.size() << " bytes, "
+		  << score << " " << scorer.unit()
+		  << (cost.internalError ? ", internal error" : "")
+		  << (failed ? " (FAILED)" : "") << "\n";
+	}
+	return passed ? 0 : 1;
+}
+
+int fuzz(const std::vector<std::string>& seedFiles, size_t runs,
+	size_t maxLen, unsigned seed, bool cpu, const std::string& outDir){
+	const size_t POPULATION = 32;
+	const size_t SAVED = 8;
+
+	//The directory may already exist
+	mkdir(outDir.c_str(), 0777);
+
+	Scorer scorer(cpu);
+	Mutator mutator(seed, maxLen);
+	std::vector<Entry> pool;
+	for (const std::string& file : seedFiles){
+		std::string input;
+		if (!readFile(file.c_str(), &input)){
+			std::cerr << "Could not read " << file << "\n";
+			return 1;
+		}
+		input.resize(std::min(input.size(), maxLen));
+		pool.push_back({input, scorer.score(measure(input), input.size())});
+	}
+	if (pool.empty()){ pool.push_back({"", 0}); }
+
+	size_t crashes = 0;
+	double best = pool[0].score;
+	for (size_t run = 0; run < runs; run++){
+		const Entry& parent = pool[mutator.below(pool.size())];
+		const Entry& other = pool[mutator.below(pool.size())];
+		std::string child = mutator.mutate(parent.input, other.input);
+		Cost cost = measure(child);
+		if (cost.internalError){
+			std::string path = outDir + "/crash-"
+				+ std::to_string(crashes++) + ".cshanty";
+			writeFile(path, child);
+			std::cout << "run " << run << ": internal error, saved "
+			  << path << "\n";
+			continue;
+		}
+		double score = scorer.score(cost, child.size());
+		if (pool.size() < POPULATION){
+			pool.push_back({child, score});
+		} else {
+			auto worst = std::min_element(pool.begin(), pool.end(),
+				[](const Entry& a, const Entry& b){
+					return a.score < b.score;
+				});
+			if (score <= worst->score){ continue; }
+			*worst = {child, score};
+		}
+		if (score > best){
+			best = score;
+			std::cout << "run " << run << ": " << child.size()
+			  << " bytes, " << score << " " << scorer.unit() << "\n";
+		}
+	}
+
+	std::sort(pool.begin(), pool.end(), [](const Entry& a, const Entry& b){
+		return a.score > b.score;
+	});
+	for (size_t i = 0; i < std::min(SAVED, pool.size()); i++){
+		std::string path = outDir + "/worst-" + std::to_string(i)
+			+ ".cshanty";
+		if (!writeFile(path, pool[i].input)){
+			std::cerr << "Could not write " << path << "\n";
+			return 1;
+		}
+		std::cout << path << ": " << pool[i].input.size() << " bytes, "
+		  << pool[i].score << " " << scorer.unit() << "\n";
+	}
+	return 0;
+}
+
+}
+
+#ifdef CSHANTY_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size);
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size){
+	static Scorer scorer(false);
+	static const char * maxScore = std::getenv("CSHANTY_FUZZ_MAX_SCORE");
+	std::string input(reinterpret_cast<const char *>(data), size);
+	Cost cost = measure(input);
+	if (cost.internalError){ std::abort(); }
+	if (maxScore != nullptr
+	  && scorer.score(cost, size) > std::atof(maxScore)){
+		std::abort();
+	}
+	return 0;
+}
+
+#else
+
+int main(int argc, char ** argv){
+	size_t runs = 100000;
+	size_t maxLen = 4096;
+	unsigned seed = 1;
+	bool cpu = false;
+	bool replaying = false;
+	double maxScore = 1e300;
+	std::string outDir = "bench/perf_corpus";
+	std::vector<std::string> files;
+	for (int i = 1; i < argc; i++){
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-t"){ cpu = true; }
+		else if (arg == "-r"){ replaying = true; }
+		else if (arg == "-n" && hasValue){
+			runs = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "-l" && hasValue){
+			maxLen = std::strtoul(argv[++i], nullptr, 10);
+		} else if (arg == "-s" && hasValue){
+			seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+		} else if (arg == "-x" && hasValue){
+			maxScore = std::atof(argv[++i]);
+		} else if (arg == "-o" && hasValue){
+			outDir = argv[++i];
+		} else if (arg[0] == '-'){
+			usageAndDie();
+		} else {
+			files.push_back(arg);
+		}
+	}
+	if (replaying){
+		if (files.empty()){ usageAndDie(); }
+		return replay(files, cpu, maxScore);
+	}
+	if (maxLen == 0){ usageAndDie(); }
+	return fuzz(files, runs, maxLen, seed, cpu, outDir);
+}
+
+#endif
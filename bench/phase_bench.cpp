@@ -0,0 +1,103 @@
+//Times each phase of the compiler on generated programs that
+// stress one dimension each (many functions, records or 
+// globals, deep nesting, long expression chains, pirate 
+// keywords). Prints one JSON object per program, with the 
+// median over the rounds of each phase's wall time, so that 
+// results can be recorded and compared. Run as
+//   bench/phase_bench [rounds] [scale]
+// where scale (default 1) multiplies the size of every program.
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "phase_run.hpp"
+#include "program_gen.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+struct Workload{
+	const char * name;
+	ProgramShape shape;
+};
+
+std::vector<Workload> workloads(size_t scale){
+	std::vector<Workload> loads;
+	ProgramShape fns;
+	fns.fns = 10000 * scale;
+	fns.globals = 20;
+	fns.depth = 2;
+	fns.chain = 8;
+	loads.push_back({"functions", fns});
+
+	ProgramShape pirate = fns;
+	pirate.pirate = true;
+	loads.push_back({"pirate", pirate});
+
+	ProgramShape records;
+	records.fns = 10;
+	records.records = 20000 * scale;
+	loads.push_back({"records", records});
+
+	ProgramShape globals;
+	globals.fns = 100;
+	globals.globals = 50000 * scale;
+	loads.push_back({"globals", globals});
+
+	ProgramShape nesting;
+	nesting.fns = 100 * scale;
+	nesting.depth = 200;
+	loads.push_back({"nesting", nesting});
+
+	ProgramShape chains;
+	chains.fns = 100 * scale;
+	chains.chain = 2000;
+	loads.push_back({"chains", chains});
+	return loads;
+}
+
+double median(std::vector<double> times){
+	std::sort(times.begin(), times.end());
+	return times[times.size() / 2];
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t rounds = 5;
+	size_t scale = 1;
+	if (argc > 1){ rounds = std::strtoul(argv[1], nullptr, 10); }
+	if (argc > 2){ scale = std::strtoul(argv[2], nullptr, 10); }
+	if (rounds == 0 || scale == 0){
+		std::cerr << "Usage: phase_bench [rounds] [scale]\n";
+		return 1;
+	}
+
+	for (const Workload& load : workloads(scale)){
+		std::string source = generateProgram(load.shape);
+		std::vector<double> times[TIMED_PHASES];
+		PhaseTimes run;
+		for (size_t r = 0; r < rounds; r++){
+			if (!timePhases(source, &run)){
+				std::cerr << load.name << ": compilation failed\n";
+				return 1;
+			}
+			for (size_t i = 0; i < TIMED_PHASES; i++){
+				times[i].push_back(run.ms[i]);
+			}
+		}
+		std::cout << "{\"program\": \"" << load.name << "\""
+		  << ", \"bytes\": " << source.size()
+		  << ", \"tokens\": " << run.tokens
+		  << ", \"nodes\": " << run.nodes
+		  << ", \"rounds\": " << rounds;
+		for (size_t i = 0; i < TIMED_PHASES; i++){
+			std::cout << ", \"" << TIMED_PHASE_NAMES[i] << "_ms\": " 
+			  << median(times[i]);
+		}
+		std::cout << "}" << std::endl;
+	}
+	return 0;
+}
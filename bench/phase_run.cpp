@@ -0,0 +1,37 @@
+#include <sstream>
+#include "phase_run.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+#include "stats.hpp"
+
+namespace cshanty{
+
+const char * const TIMED_PHASE_NAMES[TIMED_PHASES] = {
+	"lex", "parse", "names", "types", "unparse"
+};
+
+static const Phase PHASES[TIMED_PHASES] = {
+	LEX_PHASE, PARSE_PHASE, NAMES_PHASE, TYPES_PHASE, OUTPUT_PHASE
+};
+
+bool timePhases(const std::string& source, PhaseTimes * times){
+	CompilationSession session("bench", SourceBuffer::fromString(source));
+	CompilationSession::Activation active(&session);
+	if (session.typeAnalysis() == nullptr){ return false; }
+	{
+		CompileStats::Timer timer(session.phaseStats(), OUTPUT_PHASE, 
+			session.arena());
+		std::ostringstream out;
+		session.ast()->unparse(out, 0);
+	}
+	const CompileStats& stats = session.stats();
+	for (size_t i = 0; i < TIMED_PHASES; i++){
+		times->ms[i] = stats.phase(PHASES[i]).wallMs;
+	}
+	times->tokens = stats.tokens;
+	times->nodes = 0;
+	for (size_t count : stats.nodeKinds){ times->nodes += count; }
+	return true;
+}
+
+} //End namespace cshanty
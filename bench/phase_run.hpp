@@ -0,0 +1,27 @@
+#ifndef CSHANTY_BENCH_PHASE_RUN_HPP
+#define CSHANTY_BENCH_PHASE_RUN_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace cshanty{
+
+//The phases timed by the benchmarks, in order; the last is an
+// unparse of the AST
+const size_t TIMED_PHASES = 5;
+extern const char * const TIMED_PHASE_NAMES[TIMED_PHASES];
+
+//The wall time of each phase of one compilation of a program
+struct PhaseTimes{
+	double ms[TIMED_PHASES];
+	size_t tokens;
+	size_t nodes;
+};
+
+//Compile source through type analysis, then unparse it. 
+// Returns false if any phase fails.
+bool timePhases(const std::string& source, PhaseTimes * times);
+
+} //End namespace cshanty
+
+#endif
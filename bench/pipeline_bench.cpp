@@ -0,0 +1,102 @@
+//Compares lexing then parsing with lexing on a thread of its
+// own that feeds the parser through a TokenPipe (--pipeline),
+// on generated programs with and without pirate keywords.
+// Each program is first compiled both ways and the unparsed
+// ASTs compared, then timed from the start of lexing to the
+// end of parsing. The pipeline's stall and occupancy counters
+// from the last round show whether the two threads kept pace
+// with each other. Run as
+//   bench/pipeline_bench [functions] [rounds]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "program_gen.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+//The time to lex and parse the text, the unparsed AST if asked
+// for, and the pipeline's counters
+double timeParse(const std::string& text, ScannerKind kind,
+	bool pipelined, std::string * unparsed, PipelineStats * pipeline
+){
+	CompilationSession session("bench", SourceBuffer::fromString(text));
+	session.useScanner(kind);
+	session.usePipeline(pipelined);
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	ProgramNode * ast = session.ast();
+	std::chrono::duration<double, std::milli> elapsed =
+		std::chrono::steady_clock::now() - start;
+	if (ast == nullptr){
+		std::cerr << "The program didn't parse\n";
+		std::exit(1);
+	}
+	if (unparsed != nullptr){
+		CompilationSession::Activation active(&session);
+		std::ostringstream out;
+		ast->unparse(out, 0);
+		*unparsed = out.str();
+	}
+	*pipeline = session.stats().pipeline;
+	return elapsed.count();
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t fns = 20000;
+	size_t rounds = 5;
+	if (argc > 1){ fns = std::strtoul(argv[1], nullptr, 10); }
+	if (argc > 2){ rounds = std::strtoul(argv[2], nullptr, 10); }
+	if (fns == 0 || rounds == 0){
+		std::cerr << "Usage: pipeline_bench [functions] [rounds]\n";
+		return 1;
+	}
+
+	for (bool pirate : {false, true}){
+		ProgramShape shape;
+		shape.fns = fns;
+		shape.pirate = pirate;
+		std::string source = generateProgram(shape);
+		std::cout << (pirate ? "pirate" : "plain") << ": "
+		  << source.size() << " bytes, " << rounds << " rounds\n";
+
+		for (ScannerKind kind : {FLEX_SCANNER, HAND_SCANNER}){
+			PipelineStats pipeline;
+			std::string serial;
+			std::string overlapped;
+			timeParse(source, kind, false, &serial, &pipeline);
+			timeParse(source, kind, true, &overlapped, &pipeline);
+			if (serial != overlapped){
+				std::cerr << "The pipelined AST differs\n";
+				return 1;
+			}
+
+			const char * name = kind == HAND_SCANNER ? "hand" : "flex";
+			for (bool pipelined : {false, true}){
+				double ms = 0;
+				for (size_t r = 0; r < rounds; r++){
+					ms += timeParse(source, kind, pipelined, nullptr,
+						&pipeline);
+				}
+				std::cout << "  " << name
+				  << (pipelined ? " pipelined: " : " serial: ")
+				  << ms / static_cast<double>(rounds) << " ms/round";
+				if (pipelined){
+					std::cout << ", lexer stalls " << pipeline.lexerStalls
+					  << ", parser stalls " << pipeline.parserStalls
+					  << ", occupancy mean " << pipeline.meanOccupancy
+					  << " max " << pipeline.maxOccupancy;
+				}
+				std::cout << "\n";
+			}
+		}
+	}
+	return 0;
+}
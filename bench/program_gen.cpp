@@ -0,0 +1,163 @@
+#include <sstream>
+#include "program_gen.hpp"
+
+namespace cshanty{
+
+namespace{
+
+class Generator{
+public:
+	Generator(const ProgramShape& shapeIn) 
+	: shape(shapeIn), uses(0){ }
+
+	std::string program(){
+		for (size_t i = 0; i < shape.records; i++){ record(i); }
+		for (size_t i = 0; i < shape.globals; i++){
+			out << "int g" << i << semi() << "\n";
+		}
+		for (size_t i = 0; i < shape.fns; i++){ fn(i); }
+		mainFn();
+		return out.str();
+	}
+private:
+	//The plain spelling of a keyword or, in pirate mode, every 
+	// other time, its pirate synonym
+	const char * pick(const char * plain, const char * pirate){
+		if (shape.pirate && (uses++ % 2 == 0)){ return pirate; }
+		return plain;
+	}
+	const char * open(){ return pick("{", "ahoy"); }
+	const char * close(){ return pick("}", "shove off"); }
+	const char * semi(){ 
+		return pick(";", uses % 4 == 0 ? " heave and go" : " roll and go");
+	}
+	const char * assign(){ return pick("=", "gets"); }
+	const char * plus(){ return pick("+", "plus"); }
+	const char * minus(){ return pick("-", "minus"); }
+	const char * andOp(){ return pick("&&", "and"); }
+	const char * trueLit(){ return pick("true", "aye"); }
+	const char * ret(){ return pick("return", "we'll take our leave and go"); }
+
+	//Indentation stops growing past a few levels, so that the
+	// size of deeply nested programs stays linear in the depth
+	void indent(size_t level){
+		if (level > 8){ level = 8; }
+		for (size_t i = 0; i < level; i++){ out << "\t"; }
+	}
+
+	void record(size_t i){
+		out << "record R" << i << " " << open() << "\n"
+		  << "\tint x" << semi() << "\n"
+		  << "\tbool y" << semi() << "\n";
+		for (size_t f = 0; f < shape.fields; f++){
+			out << "\tint x" << f << semi() << "\n";
+		}
+		out << close() << "\n"
+		  << "R" << i << " r" << i << semi() << "\n";
+	}
+
+	//a + c + 1 + g0 + ... with the given number of operators
+	void chain(size_t length){
+		out << "a";
+		for (size_t i = 0; i < length; i++){
+			out << " " << plus() << " ";
+			switch (i % 3){
+			case 0: out << "c"; break;
+			case 1: out << i; break;
+			default: 
+				if (shape.globals > 0){ out << "g" << i % shape.globals; }
+				else { out << "a"; }
+			}
+		}
+	}
+
+	//Alternate if and while blocks, each with a local of its own
+	void nest(size_t level, size_t depth){
+		if (depth == 0){
+			indent(level);
+			out << "c++" << semi() << "\n";
+			indent(level);
+			out << "report c" << semi() << "\n";
+			return;
+		}
+		indent(level);
+		if (depth % 2 == 0){
+			out << "if (b " << andOp() << " c < " << depth * 10 << ") " 
+			  << open() << "\n";
+		} else {
+			out << "while (c > " << depth << ") " << open() << "\n";
+			indent(level + 1);
+			out << "c " << assign() << " c " << minus() << " 1" 
+			  << semi() << "\n";
+		}
+		indent(level + 1);
+		out << "int e" << depth << semi() << "\n";
+		indent(level + 1);
+		out << "e" << depth << " " << assign() << " c" << semi() << "\n";
+		nest(level + 1, depth - 1);
+		indent(level);
+		out << close() << "\n";
+	}
+
+	//The extra args of a call
+	void args(const char * arg){
+		for (size_t p = 0; p < shape.params; p++){ out << ", " << arg; }
+	}
+
+	void fn(size_t i){
+		out << "int f" << i << "(int a, bool b";
+		for (size_t p = 0; p < shape.params; p++){ out << ", int p" << p; }
+		out << ") " << open() << "\n"
+		  << "\tint c" << semi() << "\n"
+		  << "\tint d" << semi() << "\n"
+		  << "\tc " << assign() << " a * 3 " << minus() << " a / 2" 
+		  << semi() << "\n"
+		  << "\td " << assign() << " ";
+		chain(shape.chain);
+		out << semi() << "\n";
+		nest(1, shape.depth);
+		for (size_t s = 0; s < shape.siblings; s++){
+			out << "\tif (b) " << open() << " int s" << semi() 
+			  << " s " << assign() << " c" << semi() << " " << close() << "\n";
+		}
+		if (i > 0){
+			out << "\td " << assign() << " f" << i - 1 << "(c, !b";
+			args("c");
+			out << ")" << semi() << "\n"
+			  << "\tf" << i - 1 << "(d, b";
+			args("d");
+			out << ")" << semi() << "\n";
+		}
+		out << "\treceive d" << semi() << "\n";
+		out << "\t" << ret() << " d" << semi() << "\n"
+		  << close() << "\n";
+	}
+
+	void mainFn(){
+		out << "void main() " << open() << "\n"
+		  << "\tint r" << semi() << "\n";
+		if (shape.fns > 0){
+			out << "\tr " << assign() << " f" << shape.fns - 1 << "(1, " 
+			  << trueLit();
+			args("1");
+			out << ")" << semi() << "\n";
+		}
+		out << "\treport r" << semi() << "\n"
+		  << "\treport \"done\"" << semi() << "\n"
+		  << "\t" << ret() << semi() << "\n"
+		  << close() << "\n";
+	}
+
+	const ProgramShape& shape;
+	std::ostringstream out;
+	size_t uses;
+};
+
+}
+
+std::string generateProgram(const ProgramShape& shape){
+	Generator generator(shape);
+	return generator.program();
+}
+
+} //End namespace cshanty
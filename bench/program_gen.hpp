@@ -0,0 +1,41 @@
+#ifndef CSHANTY_BENCH_PROGRAM_GEN_HPP
+#define CSHANTY_BENCH_PROGRAM_GEN_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace cshanty{
+
+//The scale of a generated program along each dimension that
+// stresses a different part of the compiler
+struct ProgramShape{
+	//Functions, each calling the one before it
+	size_t fns = 100;
+	//Record types, and a global of each
+	size_t records = 10;
+	//Globals of type int, used by the functions' expressions
+	size_t globals = 50;
+	//Depth of the nested if/while blocks in each function
+	size_t depth = 4;
+	//Length of the left-associative + chain in each function
+	size_t chain = 16;
+	//Int fields of each record, besides x and y
+	size_t fields = 0;
+	//Sibling if blocks, each with a local, in each function
+	size_t siblings = 0;
+	//Int formals of each function, besides a and b (and so
+	// also args of each call)
+	size_t params = 0;
+	//Use the pirate synonyms (ahoy, shove off, heave and go, 
+	// gets, plus, aye, ...) for about half of the keywords that
+	// have them
+	bool pirate = false;
+};
+
+//A valid cshanty program (one that passes type analysis) of 
+// the given shape. The same shape always gives the same text.
+std::string generateProgram(const ProgramShape& shape);
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,151 @@
+//Checks that no phase grows much faster than linearly on 
+// programs shaped to provoke quadratic behavior: many sibling
+// scopes, huge parameter lists, records with thousands of 
+// fields, deep nesting, long expression chains, and many
+// functions, records or globals. Each shape is compiled at 
+// sizes N, 2N and 4N; a phase fails if its time at 4N is more
+// than MAX_GROWTH times its time at N (linear is 4, quadratic
+// 16). Phases too fast to time reliably are not judged. Run as
+//   bench/scaling_test [scale]
+// and exits with 1 if any phase fails.
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "phase_run.hpp"
+#include "program_gen.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+const double MAX_GROWTH = 10;
+//Times at 4N below this are mostly noise
+const double MIN_JUDGED_MS = 2;
+const size_t ROUNDS = 3;
+
+struct Family{
+	const char * name;
+	//The shape at size n
+	ProgramShape (*shape)(size_t n);
+	size_t baseSize;
+	//Phases whose output is inherently superlinear in the size
+	// (e.g. unparse indents every nesting level), and so not
+	// judged, as a mask of phase indices
+	unsigned skip;
+};
+
+ProgramShape small(){
+	ProgramShape shape;
+	shape.fns = 4;
+	shape.records = 2;
+	shape.globals = 4;
+	shape.depth = 2;
+	shape.chain = 4;
+	return shape;
+}
+
+ProgramShape functions(size_t n){ 
+	ProgramShape s = small(); s.fns = n; return s; 
+}
+ProgramShape pirate(size_t n){ 
+	ProgramShape s = functions(n); s.pirate = true; return s; 
+}
+ProgramShape records(size_t n){ 
+	ProgramShape s = small(); s.records = n; return s; 
+}
+ProgramShape fields(size_t n){ 
+	ProgramShape s = small(); s.fields = n; return s; 
+}
+ProgramShape globals(size_t n){ 
+	ProgramShape s = small(); s.globals = n; return s; 
+}
+ProgramShape siblings(size_t n){ 
+	ProgramShape s = small(); s.siblings = n; return s; 
+}
+ProgramShape params(size_t n){ 
+	ProgramShape s = small(); s.params = n; return s; 
+}
+ProgramShape nesting(size_t n){ 
+	ProgramShape s = small(); s.depth = n; return s; 
+}
+ProgramShape chains(size_t n){ 
+	ProgramShape s = small(); s.chain = n; return s; 
+}
+
+const unsigned SKIP_UNPARSE = 1u << (TIMED_PHASES - 1);
+
+const Family FAMILIES[] = {
+	{"functions", functions, 2000, 0},
+	{"pirate", pirate, 2000, 0},
+	{"records", records, 8000, 0},
+	{"fields", fields, 5000, 0},
+	{"globals", globals, 30000, 0},
+	{"siblings", siblings, 3000, 0},
+	{"params", params, 6000, 0},
+	{"nesting", nesting, 800, SKIP_UNPARSE},
+	{"chains", chains, 20000, 0},
+};
+
+//The fastest of a few runs, which is the least noisy
+bool bestTimes(const std::string& source, PhaseTimes * best){
+	for (size_t r = 0; r < ROUNDS; r++){
+		PhaseTimes run;
+		if (!timePhases(source, &run)){ return false; }
+		for (size_t i = 0; i < TIMED_PHASES; i++){
+			best->ms[i] = r == 0 ? run.ms[i] : std::min(best->ms[i], run.ms[i]);
+		}
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t scale = 1;
+	if (argc > 1){ scale = std::strtoul(argv[1], nullptr, 10); }
+	if (scale == 0){
+		std::cerr << "Usage: scaling_test [scale]\n";
+		return 1;
+	}
+
+	bool passed = true;
+	std::cout << std::fixed << std::setprecision(2);
+	for (const Family& family : FAMILIES){
+		PhaseTimes times[3];
+		bool compiled = true;
+		for (size_t k = 0; k < 3; k++){
+			size_t n = family.baseSize * scale << k;
+			std::string source = generateProgram(family.shape(n));
+			if (!bestTimes(source, &times[k])){
+				std::cout << family.name << " at " << n 
+				  << ": compilation failed\n";
+				compiled = false;
+				passed = false;
+				break;
+			}
+		}
+		if (!compiled){ continue; }
+
+		for (size_t i = 0; i < TIMED_PHASES; i++){
+			double growth = times[2].ms[i] / std::max(times[0].ms[i], 0.001);
+			const char * verdict = "ok";
+			if (family.skip & (1u << i)){
+				verdict = "not judged";
+			} else if (times[2].ms[i] < MIN_JUDGED_MS){
+				verdict = "too fast to judge";
+			} else if (growth > MAX_GROWTH){
+				verdict = "FAILED";
+				passed = false;
+			}
+			std::cout << family.name << " " << TIMED_PHASE_NAMES[i] << ": "
+			  << times[0].ms[i] << " / " << times[1].ms[i] << " / " 
+			  << times[2].ms[i] << " ms at N / 2N / 4N, growth " 
+			  << growth << " (" << verdict << ")\n";
+		}
+	}
+	std::cout << (passed ? "Scaling test passed\n" : "Scaling test FAILED\n");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+//Compares the flex scanner with the hand-written one, under
+// each set of kernels this CPU can run and on every hardware
+// thread (ParallelLexer), on generated programs
+// with and without pirate keywords. Each program is first
+// lexed by every scanner and their token streams compared,
+// then timed. The memory the tokens take up (the token
+// buffer and anything lexing put in the arena) is reported per
+// token. Run as
+//   bench/scanner_bench [functions] [rounds]
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "program_gen.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+struct Config{
+	ScannerKind kind;
+	KernelSet kernels;
+	size_t threads;
+};
+
+std::string configName(const Config& config){
+	if (config.kind == FLEX_SCANNER){ return "flex"; }
+	std::string name = std::string("hand/") + kernelSetName(config.kernels);
+	if (config.threads > 1){
+		name += " x" + std::to_string(config.threads);
+	}
+	return name;
+}
+
+//The flex scanner, then the hand-written one with each set
+// of kernels up to the best this CPU has, then with the best
+// kernels on every thread
+std::vector<Config> configs(){
+	std::vector<Config> result;
+	result.push_back(Config{FLEX_SCANNER, SCALAR_KERNELS, 1});
+	for (KernelSet kernels : {SCALAR_KERNELS, SSE2_KERNELS, AVX2_KERNELS}){
+		if (kernels > bestKernels()){ break; }
+		result.push_back(Config{HAND_SCANNER, kernels, 1});
+	}
+	size_t threads = std::thread::hardware_concurrency();
+	if (threads > 1){
+		result.push_back(Config{HAND_SCANNER, bestKernels(), threads});
+	}
+	return result;
+}
+
+//The time to lex the text, the bytes the tokens take up and
+// the -t output if asked for
+double timeLex(const std::string& text, const Config& config,
+	size_t * tokens, size_t * bytes, std::string * written
+){
+	CompilationSession session("bench", SourceBuffer::fromString(text));
+	session.useScanner(config.kind, config.kernels);
+	session.useLexThreads(config.threads);
+	TokenStream * stream = session.tokens();
+	*tokens = stream->size();
+	*bytes = stream->bytes();
+	if (written != nullptr){
+		std::ostringstream out;
+		session.writeTokens(out);
+		*written = out.str();
+	}
+	return session.stats().phase(LEX_PHASE).wallMs;
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t fns = 20000;
+	size_t rounds = 5;
+	if (argc > 1){ fns = std::strtoul(argv[1], nullptr, 10); }
+	if (argc > 2){ rounds = std::strtoul(argv[2], nullptr, 10); }
+	if (fns == 0 || rounds == 0){
+		std::cerr << "Usage: scanner_bench [functions] [rounds]\n";
+		return 1;
+	}
+
+	for (bool pirate : {false, true}){
+		ProgramShape shape;
+		shape.fns = fns;
+		shape.pirate = pirate;
+		std::string source = generateProgram(shape);
+
+		size_t tokens;
+		size_t bytes;
+		std::string fromFlex;
+		timeLex(source, configs()[0], &tokens, &bytes, &fromFlex);
+		for (const Config& config : configs()){
+			std::string written;
+			timeLex(source, config, &tokens, &bytes, &written);
+			if (written != fromFlex){
+				std::cerr << "The tokens of " << configName(config)
+				  << " differ from flex's\n";
+				return 1;
+			}
+		}
+
+		std::cout << (pirate ? "pirate" : "plain") << ": "
+		  << source.size() << " bytes, " << tokens << " tokens, "
+		  << rounds << " rounds\n";
+		for (const Config& config : configs()){
+			double ms = 0;
+			for (size_t r = 0; r < rounds; r++){
+				ms += timeLex(source, config, &tokens, &bytes, nullptr);
+			}
+			double perRound = ms / static_cast<double>(rounds);
+			std::cout << "  " << configName(config) << ": " << perRound
+			  << " ms/round, "
+			  << static_cast<double>(tokens) / perRound / 1e3
+			  << "M tokens/s, "
+			  << static_cast<double>(bytes) / static_cast<double>(tokens)
+			  << " bytes/token\n";
+		}
+	}
+	return 0;
+}
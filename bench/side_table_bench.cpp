@@ -0,0 +1,96 @@
+//Compares looking up per-node facts in a hash map keyed by
+// node pointer (as TypeAnalysis used to) with the NodeMap side
+// table indexed by NodeId. Run as
+//   bench/side_table_bench [nodes] [rounds]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "node_ids.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+class BenchNode : public ASTNode{
+public:
+	BenchNode(Position * p) : ASTNode(p){ }
+	void unparse(std::ostream&, int) override { }
+	uint32_t serialize(AstWriter *) override { return 0; }
+	bool nameAnalysis(SymbolTable *) override { return true; }
+};
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start){
+	std::chrono::duration<double, std::milli> elapsed = 
+		Clock::now() - start;
+	return elapsed.count();
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t nodes = 1000000;
+	size_t rounds = 5;
+	if (argc > 1){ nodes = std::strtoul(argv[1], nullptr, 10); }
+	if (argc > 2){ rounds = std::strtoul(argv[2], nullptr, 10); }
+
+	Arena arena;
+	NodeIds ids;
+	Arena::Scope arenaScope(&arena);
+	NodeIds::Scope idScope(&ids);
+
+	std::vector<ASTNode *> tree;
+	tree.reserve(nodes);
+	for (size_t i = 0; i < nodes; i++){
+		Position pos(i, i + 1);
+		tree.push_back(new BenchNode(&pos));
+	}
+	//Fake "types": any non-null pointer will do
+	std::vector<int> types(16);
+	for (size_t i = 0; i < types.size(); i++){ 
+		types[i] = static_cast<int>(i); 
+	}
+
+	//The pattern type analysis has: each node's type is set
+	// once and then read back (twice, for the old map)
+	size_t sink = 0;
+	Clock::time_point start = Clock::now();
+	for (size_t r = 0; r < rounds; r++){
+		std::unordered_map<const ASTNode *, const int *> byPtr;
+		for (size_t i = 0; i < nodes; i++){
+			byPtr[tree[i]] = &types[i % types.size()];
+		}
+		for (size_t i = 0; i < nodes; i++){
+			if (byPtr[tree[i]] != nullptr){ 
+				sink += static_cast<size_t>(*byPtr[tree[i]]);
+			}
+		}
+	}
+	double mapMs = msSince(start);
+
+	start = Clock::now();
+	for (size_t r = 0; r < rounds; r++){
+		NodeMap<ASTNode, const int *> byId(nullptr);
+		byId.reserve(ids.size());
+		for (size_t i = 0; i < nodes; i++){
+			byId.set(tree[i], &types[i % types.size()]);
+		}
+		for (size_t i = 0; i < nodes; i++){
+			const int * res = byId.get(tree[i]);
+			if (res != nullptr){ sink += static_cast<size_t>(*res); }
+		}
+	}
+	double vecMs = msSince(start);
+
+	std::cout << nodes << " nodes, " << rounds << " rounds\n"
+	  << "  pointer hash map: " << mapMs / rounds << " ms/round\n"
+	  << "  NodeId side table: " << vecMs / rounds << " ms/round\n"
+	  << "  speedup: " << mapMs / vecMs << "x\n"
+	  << "  (checksum " << sink << ")\n";
+	return 0;
+}
@@ -0,0 +1,137 @@
+//Times type analysis of an expression-heavy program, built 
+// directly as an AST so that only name and type analysis are
+// measured. Run as
+//   bench/typecheck_bench [statements] [rounds]
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "interner.hpp"
+#include "name_analysis.hpp"
+#include "node_ids.hpp"
+#include "type_analysis.hpp"
+#include "type_context.hpp"
+
+using namespace cshanty;
+
+namespace{
+
+using Clock = std::chrono::steady_clock;
+
+double msSince(Clock::time_point start){
+	std::chrono::duration<double, std::milli> elapsed = 
+		Clock::now() - start;
+	return elapsed.count();
+}
+
+Position nowhere;
+
+IDNode * id(SymbolId name){ return new IDNode(&nowhere, name); }
+
+//a + a * 3 - a / a + ... with the given number of operators
+ExpNode * intExp(SymbolId a, size_t ops){
+	ExpNode * exp = id(a);
+	for (size_t i = 0; i < ops; i++){
+		switch (i % 4){
+		case 0: exp = new PlusNode(&nowhere, exp, id(a)); break;
+		case 1: exp = new TimesNode(&nowhere, exp, 
+			new IntLitNode(&nowhere, 3)); break;
+		case 2: exp = new MinusNode(&nowhere, exp, id(a)); break;
+		default: exp = new DivideNode(&nowhere, exp, id(a)); break;
+		}
+	}
+	return exp;
+}
+
+//a < a && b || !b == b ... with the given number of operators
+ExpNode * boolExp(SymbolId a, SymbolId b, size_t ops){
+	ExpNode * exp = id(b);
+	for (size_t i = 0; i < ops; i++){
+		switch (i % 4){
+		case 0: exp = new AndNode(&nowhere, exp, 
+			new LessNode(&nowhere, id(a), id(a))); break;
+		case 1: exp = new OrNode(&nowhere, exp, 
+			new NotNode(&nowhere, id(b))); break;
+		case 2: exp = new EqualsNode(&nowhere, exp, id(b)); break;
+		default: exp = new NotEqualsNode(&nowhere, exp, 
+			new TrueNode(&nowhere)); break;
+		}
+	}
+	return exp;
+}
+
+ProgramNode * buildProgram(size_t stmts){
+	Interner * names = Interner::current();
+	SymbolId a = names->intern("a");
+	SymbolId b = names->intern("b");
+
+	ArenaList<StmtNode *> * body = new ArenaList<StmtNode *>();
+	body->push_back(new VarDeclNode(&nowhere, 
+		new IntTypeNode(&nowhere), id(a)));
+	body->push_back(new VarDeclNode(&nowhere, 
+		new BoolTypeNode(&nowhere), id(b)));
+	for (size_t i = 0; i < stmts; i++){
+		ExpNode * src; 
+		LValNode * dst;
+		if (i % 2 == 0){
+			dst = id(a);
+			src = intExp(a, 16);
+		} else {
+			dst = id(b);
+			src = boolExp(a, b, 16);
+		}
+		body->push_back(new AssignStmtNode(&nowhere, 
+			new AssignExpNode(&nowhere, dst, src)));
+	}
+
+	ArenaList<DeclNode *> * globals = new ArenaList<DeclNode *>();
+	globals->push_back(new FnDeclNode(&nowhere, 
+		new VoidTypeNode(&nowhere), id(names->intern("main")),
+		new ArenaList<FormalDeclNode *>(), body));
+	return new ProgramNode(globals);
+}
+
+}
+
+int main(int argc, char ** argv){
+	size_t stmts = 50000;
+	size_t rounds = 10;
+	if (argc > 1){ stmts = std::strtoul(argv[1], nullptr, 10); }
+	if (argc > 2){ rounds = std::strtoul(argv[2], nullptr, 10); }
+
+	Arena arena;
+	Interner interner;
+	NodeIds ids;
+	TypeContext typeContext;
+	Arena::Scope arenaScope(&arena);
+	Interner::Scope internerScope(&interner);
+	NodeIds::Scope idScope(&ids);
+	TypeContext::Scope typeScope(&typeContext);
+
+	ProgramNode * program = buildProgram(stmts);
+	cshanty::NameAnalysis * names = cshanty::NameAnalysis::build(program);
+	if (names == nullptr){
+		std::cerr << "Name analysis failed\n";
+		return 1;
+	}
+
+	//Type analysis only reads the AST, so it can be rerun
+	Clock::time_point start = Clock::now();
+	for (size_t r = 0; r < rounds; r++){
+		TypeAnalysis * types = TypeAnalysis::build(names);
+		if (types == nullptr){
+			std::cerr << "Type analysis failed\n";
+			return 1;
+		}
+		delete types;
+	}
+	double ms = msSince(start);
+
+	std::cout << stmts << " statements, " << ids.size() << " nodes, "
+	  << rounds << " rounds\n"
+	  << "  type analysis: " << ms / rounds << " ms/round ("
+	  << ids.size() * rounds / (ms / 1000) / 1e6
+	  << "M nodes/s)\n";
+	return 0;
+}
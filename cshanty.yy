@@ -13,7 +13,7 @@
 	#include "tokens.hpp"
 	#include "ast.hpp"
 	namespace cshanty {
-		class Scanner;
+		class TokenStream;
 	}
 
 //The following definition is required when 
@@ -29,7 +29,7 @@
 //End "requires" code
 }
 
-%parse-param { cshanty::Scanner &scanner }
+%parse-param { cshanty::TokenStream &tokens }
 %parse-param { cshanty::ProgramNode** root }
 %code{
    // C std code for utility functions
@@ -38,42 +38,38 @@
    #include <fstream>
 
    // Our code for interoperation between scanner/parser
-   #include "scanner.hpp"
+   #include "token_stream.hpp"
    #include "ast.hpp"
    #include "tokens.hpp"
 
-  //Request tokens from our scanner member, not 
-  // from a global function
+  //Request tokens from the already-lexed token
+  // stream, not from a global function
   #undef yylex
-  #define yylex scanner.yylex
+  #define yylex tokens.next
 }
 
 %union {
-   bool                                  transBool;
-   cshanty::Token*                         transToken;
-   cshanty::Token*                         lexeme;
-   cshanty::IDToken*                       transIDToken;
-   cshanty::IntLitToken*                   transIntToken;
-   cshanty::StrToken*                      transStrToken;
-   cshanty::ProgramNode*                   transProgram;
-   cshanty::DeclNode *                     transDecl;
-   std::list<cshanty::DeclNode *> *        transDeclList;
-   cshanty::RecordTypeDeclNode *           transRecordDecl;
-   cshanty::VarDeclNode *                  transVarDecl;
-   std::list<cshanty::VarDeclNode *> *     transVarDeclList;
-   cshanty::FormalDeclNode *               transFormal;
-   std::list<cshanty::FormalDeclNode *> *  transFormalList;
-   cshanty::TypeNode *                     transType;
-   cshanty::LValNode *                     transLVal;
-   cshanty::IDNode *                       transID;
-   cshanty::FnDeclNode *                   transFn;
-   std::list<cshanty::VarDeclNode *> *     transVarDecls;
-   std::list<cshanty::StmtNode *> *        transStmts;
-   cshanty::StmtNode *                     transStmt;
-   cshanty::ExpNode *                      transExp;
-   cshanty::AssignExpNode *                transAssignExp;
-   cshanty::CallExpNode *                  transCallExp;
-   std::list<cshanty::ExpNode *> *         transActuals;
+   bool                                            transBool;
+   cshanty::TokenRef                               transToken;
+   cshanty::ProgramNode*                           transProgram;
+   cshanty::DeclNode *                             transDecl;
+   cshanty::ArenaList<cshanty::DeclNode *> *       transDeclList;
+   cshanty::RecordTypeDeclNode *                   transRecordDecl;
+   cshanty::VarDeclNode *                          transVarDecl;
+   cshanty::ArenaList<cshanty::VarDeclNode *> *    transVarDeclList;
+   cshanty::FormalDeclNode *                       transFormal;
+   cshanty::ArenaList<cshanty::FormalDeclNode *> * transFormalList;
+   cshanty::TypeNode *                             transType;
+   cshanty::LValNode *                             transLVal;
+   cshanty::IDNode *                               transID;
+   cshanty::FnDeclNode *                           transFn;
+   cshanty::ArenaList<cshanty::VarDeclNode *> *    transVarDecls;
+   cshanty::ArenaList<cshanty::StmtNode *> *       transStmts;
+   cshanty::StmtNode *                             transStmt;
+   cshanty::ExpNode *                              transExp;
+   cshanty::AssignExpNode *                        transAssignExp;
+   cshanty::CallExpNode *                          transCallExp;
+   cshanty::ArenaList<cshanty::ExpNode *> *        transActuals;
 }
 
 %define parse.assert
@@ -92,11 +88,11 @@
 %token	<transToken>     FALSE
 %token	<transToken>     GREATER
 %token	<transToken>     GREATEREQ
-%token	<transIDToken>   ID
+%token	<transToken>     ID
 %token	<transToken>     IF
 %token	<transToken>     INC
 %token	<transToken>     INT
-%token	<transIntToken>  INTLITERAL
+%token	<transToken>     INTLITERAL
 %token	<transToken>     LBRACE
 %token	<transToken>     LESS
 %token	<transToken>     LESSEQ
@@ -115,7 +111,7 @@
 %token	<transToken>     RPAREN
 %token	<transToken>     SEMICOL
 %token	<transToken>     STRING
-%token	<transStrToken>  STRLITERAL
+%token	<transToken>     STRLITERAL
 %token	<transToken>     TIMES
 %token	<transToken>     TRUE
 %token	<transToken>     VOID
@@ -168,7 +164,7 @@ globals 	: globals decl
 	  	  }
 		| /* epsilon */
 		  {
-		  $$ = new std::list<DeclNode * >();
+		  $$ = new ArenaList<DeclNode *>();
 		  }
 
 decl 		: varDecl
@@ -180,19 +176,19 @@ decl 		: varDecl
 
 recordDecl	: RECORD id OPEN varDeclList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $5->pos());
-		  $$ = new RecordTypeDeclNode(p, $2, $4);
+		  Position p($1.pos(), $5.pos());
+		  $$ = new RecordTypeDeclNode(&p, $2, $4);
 		  }
 
 varDecl 	: type id SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new VarDeclNode(p, $1, $2);
+		  Position p($1->pos(), $2->pos());
+		  $$ = new VarDeclNode(&p, $1, $2);
 		  }
 
 varDeclList     : varDecl
 		  {
-		  $$ = new std::list<VarDeclNode *>();
+		  $$ = new ArenaList<VarDeclNode *>();
 		  $$->push_back($1);
 		  }
 		| varDeclList varDecl
@@ -203,11 +199,11 @@ varDeclList     : varDecl
 
 type 		: INT
 	  	  { 
-		  $$ = new IntTypeNode($1->pos());
+		  $$ = new IntTypeNode($1.pos());
 		  }
 		| BOOL
 		  {
-		  $$ = new BoolTypeNode($1->pos());
+		  $$ = new BoolTypeNode($1.pos());
 		  }
 		| id
 		  {
@@ -215,28 +211,28 @@ type 		: INT
 		  }
 		| STRING
 		  {
-		  $$ = new StringTypeNode($1->pos());
+		  $$ = new StringTypeNode($1.pos());
 		  }
 		| VOID
 		  {
-		  $$ = new VoidTypeNode($1->pos());
+		  $$ = new VoidTypeNode($1.pos());
 		  }
 
 fnDecl 		: type id LPAREN RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * pos = new Position($1->pos(), $7->pos());
-		  std::list<FormalDeclNode *> * f = new std::list<FormalDeclNode *>();
-		  $$ = new FnDeclNode(pos, $1, $2, f, $6);
+		  Position pos($1->pos(), $7.pos());
+		  ArenaList<FormalDeclNode *> * f = new ArenaList<FormalDeclNode *>();
+		  $$ = new FnDeclNode(&pos, $1, $2, f, $6);
 		  }
 		| type id LPAREN formals RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * pos = new Position($1->pos(), $8->pos());
-		  $$ = new FnDeclNode(pos, $1, $2, $4, $7);
+		  Position pos($1->pos(), $8.pos());
+		  $$ = new FnDeclNode(&pos, $1, $2, $4, $7);
 		  }
 
 formals 	: formalDecl
 		  {
-		  $$ = new std::list<FormalDeclNode *>();
+		  $$ = new ArenaList<FormalDeclNode *>();
 		  $$->push_back($1);
 		  }
 		| formals COMMA formalDecl
@@ -247,13 +243,13 @@ formals 	: formalDecl
 
 formalDecl 	: type id
 		  {
-		  Position * pos = new Position($1->pos(), $2->pos());
-		  $$ = new FormalDeclNode(pos, $1, $2);
+		  Position pos($1->pos(), $2->pos());
+		  $$ = new FormalDeclNode(&pos, $1, $2);
 		  }
 
 stmtList 	: /* epsilon */
 	   	  {
-		  $$ = new std::list<StmtNode *>();
+		  $$ = new ArenaList<StmtNode *>();
 		  //$$->push_back($1);
 	   	  }
 		| stmtList stmt
@@ -269,158 +265,158 @@ stmt		: varDecl
 		  }
 		| assignExp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new AssignStmtNode(p, $1); 
+		  Position p($1->pos(), $2.pos());
+		  $$ = new AssignStmtNode(&p, $1); 
 		  }
 		| lval DEC SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PostDecStmtNode(p, $1);
+		  Position p($1->pos(), $3.pos());
+		  $$ = new PostDecStmtNode(&p, $1);
 		  }
 		| lval INC SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PostIncStmtNode(p, $1);
+		  Position p($1->pos(), $3.pos());
+		  $$ = new PostIncStmtNode(&p, $1);
 		  }
 		| RECEIVE lval SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReceiveStmtNode(p, $2);
+		  Position p($1.pos(), $3.pos());
+		  $$ = new ReceiveStmtNode(&p, $2);
 		  }
 		| REPORT exp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReportStmtNode(p, $2);
+		  Position p($1.pos(), $3.pos());
+		  $$ = new ReportStmtNode(&p, $2);
 		  }
 		| IF LPAREN exp RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $7->pos());
-		  $$ = new IfStmtNode(p, $3, $6);
+		  Position p($1.pos(), $7.pos());
+		  $$ = new IfStmtNode(&p, $3, $6);
 		  }
 		| IF LPAREN exp RPAREN OPEN stmtList CLOSE ELSE OPEN stmtList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $11->pos());
-		  $$ = new IfElseStmtNode(p, $3, $6, $10);
+		  Position p($1.pos(), $11.pos());
+		  $$ = new IfElseStmtNode(&p, $3, $6, $10);
 		  }
 		| WHILE LPAREN exp RPAREN OPEN stmtList CLOSE
 		  {
-		  Position * p = new Position($1->pos(), $7->pos());
-		  $$ = new WhileStmtNode(p, $3, $6);
+		  Position p($1.pos(), $7.pos());
+		  $$ = new WhileStmtNode(&p, $3, $6);
 		  }
 		| RETURN exp SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new ReturnStmtNode(p, $2);
+		  Position p($1.pos(), $3.pos());
+		  $$ = new ReturnStmtNode(&p, $2);
 		  }
 		| RETURN SEMICOL
 		  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new ReturnStmtNode(p, nullptr);
+		  Position p($1.pos(), $2.pos());
+		  $$ = new ReturnStmtNode(&p, nullptr);
 		  }
 		| callExp SEMICOL
 		  { 
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new CallStmtNode(p, $1); 
+		  Position p($1->pos(), $2.pos());
+		  $$ = new CallStmtNode(&p, $1); 
 		  }
 
 exp		: assignExp 
 		  { $$ = $1; } 
 		| exp MINUS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new MinusNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new MinusNode(&p, $1, $3);
 		  }
 		| exp PLUS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new PlusNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new PlusNode(&p, $1, $3);
 		  }
 		| exp TIMES exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new TimesNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new TimesNode(&p, $1, $3);
 		  }
 		| exp DIVIDE exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new DivideNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new DivideNode(&p, $1, $3);
 		  }
 		| exp AND exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new AndNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new AndNode(&p, $1, $3);
 		  }
 		| exp OR exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new OrNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new OrNode(&p, $1, $3);
 		  }
 		| exp EQUALS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new EqualsNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new EqualsNode(&p, $1, $3);
 		  }
 		| exp NOTEQUALS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new NotEqualsNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new NotEqualsNode(&p, $1, $3);
 		  }
 		| exp GREATER exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new GreaterNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new GreaterNode(&p, $1, $3);
 		  }
 		| exp GREATEREQ exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new GreaterEqNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new GreaterEqNode(&p, $1, $3);
 		  }
 		| exp LESS exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new LessNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new LessNode(&p, $1, $3);
 		  }
 		| exp LESSEQ exp
 	  	  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new LessEqNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new LessEqNode(&p, $1, $3);
 		  }
 		| NOT exp
 	  	  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new NotNode(p, $2);
+		  Position p($1.pos(), $2->pos());
+		  $$ = new NotNode(&p, $2);
 		  }
 		| MINUS term
 	  	  {
-		  Position * p = new Position($1->pos(), $2->pos());
-		  $$ = new NegNode(p, $2);
+		  Position p($1.pos(), $2->pos());
+		  $$ = new NegNode(&p, $2);
 		  }
 		| term 
 	  	  { $$ = $1; }
 
 assignExp	: lval ASSIGN exp
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  $$ = new AssignExpNode(p, $1, $3);
+		  Position p($1->pos(), $3->pos());
+		  $$ = new AssignExpNode(&p, $1, $3);
 		  }
 
 callExp		: id LPAREN RPAREN
 		  {
-		  Position * p = new Position($1->pos(), $3->pos());
-		  std::list<ExpNode *> * noargs =
-		    new std::list<ExpNode *>();
-		  $$ = new CallExpNode(p, $1, noargs);
+		  Position p($1->pos(), $3.pos());
+		  ArenaList<ExpNode *> * noargs =
+		    new ArenaList<ExpNode *>();
+		  $$ = new CallExpNode(&p, $1, noargs);
 		  }
 		| id LPAREN actualsList RPAREN
 		  {
-		  Position * p = new Position($1->pos(), $4->pos());
-		  $$ = new CallExpNode(p, $1, $3);
+		  Position p($1->pos(), $4.pos());
+		  $$ = new CallExpNode(&p, $1, $3);
 		  }
 
 actualsList	: exp
 		  {
-		  std::list<ExpNode *> * list =
-		    new std::list<ExpNode *>();
+		  ArenaList<ExpNode *> * list =
+		    new ArenaList<ExpNode *>();
 		  list->push_back($1);
 		  $$ = list;
 		  }
@@ -433,13 +429,13 @@ actualsList	: exp
 term 		: lval
 		  { $$ = $1; }
 		| INTLITERAL 
-		  { $$ = new IntLitNode($1->pos(), $1->num()); }
+		  { $$ = new IntLitNode($1.pos(), $1.num()); }
 		| STRLITERAL 
-		  { $$ = new StrLitNode($1->pos(), $1->str()); }
+		  { $$ = new StrLitNode($1.pos(), $1.view()); }
 		| TRUE
-		  { $$ = new TrueNode($1->pos()); }
+		  { $$ = new TrueNode($1.pos()); }
 		| FALSE
-		  { $$ = new FalseNode($1->pos()); }
+		  { $$ = new FalseNode($1.pos()); }
 		| LPAREN exp RPAREN
 		  { $$ = $2; }
 		| callExp
@@ -453,19 +449,19 @@ lval		: id
 		  }
 		| id LBRACE id RBRACE
 		  {
-		  Position * pos = new Position($1->pos(), $4->pos());
-		  $$ = new IndexNode(pos, $1, $3);
+		  Position pos($1->pos(), $4.pos());
+		  $$ = new IndexNode(&pos, $1, $3);
 		  }
 
 id		: ID
 		  {
-		  Position * pos = $1->pos();
-		  $$ = new IDNode(pos, $1->value()); 
+		  Position * pos = $1.pos();
+		  $$ = new IDNode(pos, $1.id()); 
 		  }
 	
 %%
 
 void cshanty::Parser::error(const std::string& msg){
-	std::cout << msg << std::endl;
-	std::cerr << "syntax error" << std::endl;
+	cshanty::Report::outStream() << msg << std::endl;
+	cshanty::Report::errStream() << "syntax error" << std::endl;
 }
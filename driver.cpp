@@ -0,0 +1,536 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <sys/stat.h>
+#include "batch.hpp"
+#include "driver.hpp"
+#include "errors.hpp"
+#include "trace.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+
+namespace cshanty{
+
+void usage(std::ostream& out){
+	out << "Usage: cshantyc <infile>... | @<fileList>\n"
+	<< " [-a <astFile>]: Save the AST (resolved, if names are\n"
+	<< "   analyzed) to <astFile>, which can be given as <infile>\n"
+	<< "   later in place of the source\n"
+	<< " [-c]: Do type checking\n"
+	<< " [-j <jobs>]: Compile multiple inputs on <jobs> threads\n"
+	<< " [-m]: Report arena memory used by each phase\n"
+	<< " [-n <nameFile>]: Perform name analysis\n"
+	<< " [-u <unparseFile>]: Output canonical program form\n"
+	<< " [-p]: Parse the input to check syntax\n"
+	<< " [-t <tokensFile>]: Output tokens to <tokensFile>\n"
+	<< " [--stats]: Report time, memory and work done by each phase\n"
+	<< " [--stats-json=<file>]: Write the same report as JSON\n"
+	<< " [--trace=<file>]: Write a Chrome trace of phases and of\n"
+	<< "   each function and record analyzed\n"
+	<< " [--scanner=hand|flex]: Lex with the hand-written scanner\n"
+	<< "   or the flex one (the default)\n"
+	<< " [--scan-kernels=scalar|sse2|avx2]: Skip whitespace,\n"
+	<< "   comments and identifiers in the hand-written scanner\n"
+	<< "   with these kernels (default: the best the CPU has)\n"
+	<< " [--lex-threads=<n>]: Lex large inputs on <n> threads with\n"
+	<< "   the hand-written scanner\n"
+	<< " [--pipeline]: Lex on a thread of its own, handing tokens\n"
+	<< "   to the parser as they are lexed\n"
+	<< " [--cache=<dir>]: Reuse results of earlier compilations\n"
+	<< " [--cache-size=<MB>]: Limit the cache size (default 256)\n"
+	<< "       cshantyc --server <socket>: Serve compile requests\n"
+	<< "       cshantyc --client <socket> <args>...: Send a compile\n"
+	<< "         request (<args> as above; '-' compiles stdin)\n"
+	<< "       cshantyc --client <socket> --stop: Stop the server\n"
+	;
+}
+
+static void writeTokenStream(CompilationSession * session, const char * outPath){
+	if (outPath == nullptr){
+		std::string msg = "No tokens output file given";
+		throw new cshanty::InternalError(msg.c_str());
+	}
+
+	session->tokens();
+	CompileStats::Timer timer(session->phaseStats(), OUTPUT_PHASE, 
+		session->arena());
+
+	if (strcmp(outPath, "--") == 0){
+		session->writeTokens(Report::outStream());
+	} else {
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new InternalError(msg.c_str());
+		}
+		session->writeTokens(outStream);
+		outStream.close();
+	}
+}
+
+static void outputAST(ASTNode * ast, const char * outPath){
+	if (strcmp(outPath, "--") == 0){
+		ast->unparse(Report::outStream(), 0);
+	} else {
+		std::ofstream outStream(outPath);
+		if (!outStream.good()){
+			std::string msg = "Bad output file ";
+			msg += outPath;
+			throw new cshanty::InternalError(msg.c_str());
+		}
+		ast->unparse(outStream, 0);
+	}
+}
+
+static void writeASTFile(CompilationSession * session, const char * outPath){
+	std::ofstream outStream(outPath, std::ios::binary);
+	if (!outStream.good()){
+		std::string msg = "Bad output file ";
+		msg += outPath;
+		throw new cshanty::InternalError(msg.c_str());
+	}
+	CompileStats::Timer timer(session->phaseStats(), OUTPUT_PHASE, 
+		session->arena());
+	session->writeAST(outStream);
+}
+
+static bool doUnparsing(CompilationSession * session, const char * outPath){
+	cshanty::ProgramNode * ast = session->ast();
+	if (ast == nullptr){ 
+		Report::errStream() << "No AST built\n";
+		return false;
+	}
+
+	CompileStats::Timer timer(session->phaseStats(), OUTPUT_PHASE, 
+		session->arena());
+	outputAST(ast, outPath);
+	return true;
+}
+
+bool parseOptions(const std::vector<std::string>& args, 
+	Options * opts, std::vector<std::string> * inFiles, 
+	std::ostream& err
+){
+	bool useful = false;
+	const char * cacheDir = nullptr;
+	uint64_t cacheLimit = ResultCache::DEFAULT_LIMIT;
+	for (size_t i = 0 ; i < args.size() ; i++){
+		const char * arg = args[i].c_str();
+		//Flags that take a value
+		const char * value = i + 1 < args.size() ? args[i + 1].c_str() : nullptr;
+		if (strncmp(arg, "--cache=", 8) == 0){
+			cacheDir = arg + 8;
+		} else if (strcmp(arg, "--stats") == 0){
+			opts->stats = true;
+		} else if (strncmp(arg, "--stats-json=", 13) == 0){
+			opts->statsJson = arg + 13;
+			if (opts->statsJson[0] == '\0'){ return false; }
+		} else if (strncmp(arg, "--trace=", 8) == 0){
+			opts->traceFile = arg + 8;
+			if (opts->traceFile[0] == '\0'){ return false; }
+		} else if (strncmp(arg, "--scanner=", 10) == 0){
+			if (strcmp(arg + 10, "hand") == 0){
+				opts->scanner = HAND_SCANNER;
+			} else if (strcmp(arg + 10, "flex") == 0){
+				opts->scanner = FLEX_SCANNER;
+			} else {
+				return false;
+			}
+		} else if (strncmp(arg, "--scan-kernels=", 15) == 0){
+			if (strcmp(arg + 15, "scalar") == 0){
+				opts->scanKernels = SCALAR_KERNELS;
+			} else if (strcmp(arg + 15, "sse2") == 0){
+				opts->scanKernels = SSE2_KERNELS;
+			} else if (strcmp(arg + 15, "avx2") == 0){
+				opts->scanKernels = AVX2_KERNELS;
+			} else {
+				return false;
+			}
+		} else if (strcmp(arg, "--pipeline") == 0){
+			opts->pipeline = true;
+		} else if (strncmp(arg, "--lex-threads=", 14) == 0){
+			opts->lexThreads = strtoul(arg + 14, nullptr, 10);
+			if (opts->lexThreads == 0){ return false; }
+		} else if (strncmp(arg, "--cache-size=", 13) == 0){
+			cacheLimit = strtoull(arg + 13, nullptr, 10) * 1024 * 1024;
+			if (cacheLimit == 0){ return false; }
+		} else if (arg[0] == '-' && arg[1] != '\0'){
+			if (arg[1] == 'a'){
+				if (value == nullptr){ return false; }
+				i++;
+				opts->astFile = value;
+				useful = true;
+			} else if (arg[1] == 't'){
+				if (value == nullptr){ return false; }
+				i++;
+				opts->tokensFile = value;
+				useful = true;
+			} else if (arg[1] == 'p'){
+				opts->checkParse = true;
+				useful = true;
+			} else if (arg[1] == 'u'){
+				if (value == nullptr){ return false; }
+				i++;
+				opts->unparseFile = value;
+				useful = true;
+			} else if (arg[1] == 'n'){
+				if (value == nullptr){ return false; }
+				i++;
+				opts->namesFile = value;
+				useful = true;
+			} else if (arg[1] == 'c'){
+				opts->checkTypes = true;
+				useful = true;
+			} else if (arg[1] == 'm'){
+				opts->reportMemory = true;
+			} else if (arg[1] == 'j'){
+				if (value == nullptr){ return false; }
+				i++;
+				opts->jobs = strtoul(value, nullptr, 10);
+				if (opts->jobs == 0){ return false; }
+			} else {
+				err << "Unrecognized argument: ";
+				err << arg << std::endl;
+				return false;
+			}
+		} else if (arg[0] == '@'){
+			if (!Batch::readFileList(arg + 1, inFiles)){
+				err << "Bad file list " << arg + 1 << std::endl;
+				return false;
+			}
+		} else {
+			inFiles->push_back(args[i]);
+		}
+	}
+	if (inFiles->empty()){
+		return false;
+	}
+	if (!useful){
+		err << "Hey, you didn't tell cshantyc to do anything!\n";
+		return false;
+	}
+	if (inFiles->size() > 1){
+		if (opts->tokensFile || opts->unparseFile || opts->namesFile
+		  || opts->astFile){
+			err << "Only 1 input file allowed with -t, -u, -n or -a\n";
+			return false;
+		}
+	}
+	if (cacheDir != nullptr){
+		opts->cache = ResultCache::open(cacheDir, cacheLimit);
+		if (opts->cache == nullptr){
+			err << "Can't use cache directory " << cacheDir << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+//Sets *deterministic (if given) to whether compiling the same 
+// source again would give the same result: not if it failed on
+// something outside the source, such as an unwritable output
+static int runPhases(CompilationSession * session, const Options& opts,
+	bool * deterministic
+){
+	std::ostream& err = Report::errStream();
+	if (deterministic != nullptr){ *deterministic = true; }
+	int exitCode = 0;
+	try {
+		if (opts.tokensFile != nullptr){
+			writeTokenStream(session, opts.tokensFile);
+		}
+		if (opts.checkParse){
+			if (!session->ast()){
+				err << "Parse failed" << std::endl;
+			}
+		}
+		if (opts.unparseFile != nullptr){
+			doUnparsing(session, opts.unparseFile);
+		}
+		if (opts.namesFile){
+			cshanty::NameAnalysis * na;
+			na = session->nameAnalysis();
+			if (na == nullptr){
+				err << "Name Analysis Failed\n";
+				return 1;
+			} else {
+				CompileStats::Timer timer(session->phaseStats(), 
+					OUTPUT_PHASE, session->arena());
+				outputAST(na->ast, opts.namesFile);
+			}
+		}
+		if (opts.checkTypes){
+			cshanty::TypeAnalysis * ta;
+			ta = session->typeAnalysis();
+			if (ta == nullptr){
+				err << "Type Analysis Failed\n";
+				return 1;
+			} else {
+				Report::outStream() 
+				  << "Great job! Type analysis succeeded\n";
+			}
+		}
+		//Last, so that the AST is saved resolved if names were
+		// analyzed, and isn't saved at all if analysis failed
+		if (opts.astFile != nullptr){
+			if (session->ast() == nullptr){
+				err << "No AST built\n";
+				exitCode = 1;
+			} else {
+				writeASTFile(session, opts.astFile);
+			}
+		}
+	} catch (cshanty::ToDoError * e){
+		err << "ToDoError: " << e->msg() << "\n";
+		exitCode = 1;
+		if (deterministic != nullptr){ *deterministic = false; }
+	} catch (cshanty::InternalError * e){
+		err << "InternalError: " << e->msg() << "\n";
+		exitCode = 1;
+		if (deterministic != nullptr){ *deterministic = false; }
+	}
+	return exitCode;
+}
+
+static bool toFile(const char * outPath){
+	return outPath != nullptr && strcmp(outPath, "--") != 0;
+}
+
+//The phases requested, and which of their outputs go to files,
+// as part of the cache key
+static std::string phaseKey(const Options& opts){
+	std::string key;
+	if (opts.tokensFile){ key += toFile(opts.tokensFile) ? "t" : "t-"; }
+	if (opts.checkParse){ key += "p"; }
+	if (opts.unparseFile){ key += toFile(opts.unparseFile) ? "u" : "u-"; }
+	if (opts.namesFile){ key += toFile(opts.namesFile) ? "n" : "n-"; }
+	if (opts.checkTypes){ key += "c"; }
+	return key;
+}
+
+//Output files are only taken to have been written by the 
+// compilation if they changed while it ran
+struct FileStamp{
+	bool exists;
+	struct stat info;
+};
+
+static FileStamp stampFile(const char * path){
+	FileStamp stamp;
+	stamp.exists = toFile(path) && stat(path, &stamp.info) == 0;
+	return stamp;
+}
+
+static bool fileWritten(const char * path, const FileStamp& before){
+	FileStamp after = stampFile(path);
+	if (!after.exists){ return false; }
+	if (!before.exists){ return true; }
+	return after.info.st_ino != before.info.st_ino
+		|| after.info.st_size != before.info.st_size
+		|| after.info.st_mtim.tv_sec != before.info.st_mtim.tv_sec
+		|| after.info.st_mtim.tv_nsec != before.info.st_mtim.tv_nsec;
+}
+
+static std::string readFile(const char * path){
+	std::ifstream in(path, std::ios::binary);
+	std::ostringstream contents;
+	contents << in.rdbuf();
+	return contents.str();
+}
+
+static void writeFile(const char * path, const std::string& contents){
+	std::ofstream out(path, std::ios::binary);
+	if (!out.good()){
+		std::string msg = "Bad output file ";
+		msg += path;
+		throw new InternalError(msg.c_str());
+	}
+	out << contents;
+}
+
+//Replay the result of compiling the same source with the same
+// phases, or compile it and keep the result for next time (if
+// another try couldn't turn out differently)
+static int compileCached(CompilationSession * session, const Options& opts){
+	const SourceBuffer * source = session->source();
+	std::string key = ResultCache::key(source->data(), source->size(), 
+		phaseKey(opts));
+
+	CachedResult result;
+	if (opts.cache->lookup(key, &result)){
+		try {
+			if (result.files & CachedResult::TOKENS){
+				writeFile(opts.tokensFile, result.tokens);
+			}
+			if (result.files & CachedResult::UNPARSE){
+				writeFile(opts.unparseFile, result.unparse);
+			}
+			if (result.files & CachedResult::NAMES){
+				writeFile(opts.namesFile, result.names);
+			}
+		} catch (cshanty::InternalError * e){
+			Report::errStream() << "InternalError: " << e->msg() << "\n";
+			return 1;
+		}
+	} else {
+		FileStamp tokensBefore = stampFile(opts.tokensFile);
+		FileStamp unparseBefore = stampFile(opts.unparseFile);
+		FileStamp namesBefore = stampFile(opts.namesFile);
+		std::ostringstream out;
+		std::ostringstream err;
+		bool deterministic;
+		{
+			Report::Scope capture(&err, &out);
+			result.exitCode = runPhases(session, opts, &deterministic);
+		}
+		result.out = out.str();
+		result.err = err.str();
+		result.files = 0;
+		if (fileWritten(opts.tokensFile, tokensBefore)){
+			result.files |= CachedResult::TOKENS;
+			result.tokens = readFile(opts.tokensFile);
+		}
+		if (fileWritten(opts.unparseFile, unparseBefore)){
+			result.files |= CachedResult::UNPARSE;
+			result.unparse = readFile(opts.unparseFile);
+		}
+		if (fileWritten(opts.namesFile, namesBefore)){
+			result.files |= CachedResult::NAMES;
+			result.names = readFile(opts.namesFile);
+		}
+		if (deterministic){ opts.cache->store(key, result); }
+	}
+	Report::outStream() << result.out << std::flush;
+	Report::errStream() << result.err << std::flush;
+	return result.exitCode;
+}
+
+int compile(CompilationSession * session, const Options& opts){
+	TraceSpan span("file", "compile", session->path());
+	session->useScanner(opts.scanner, opts.scanKernels);
+	session->useLexThreads(opts.lexThreads);
+	session->usePipeline(opts.pipeline);
+	int exitCode;
+	//.csast files aren't worth caching: they're a cache already
+	if (opts.cache != nullptr && opts.astFile == nullptr){
+		exitCode = compileCached(session, opts);
+	} else {
+		exitCode = runPhases(session, opts, nullptr);
+	}
+
+	if (opts.reportMemory){
+		session->reportMemory(Report::errStream());
+		if (opts.cache != nullptr){ opts.cache->report(Report::errStream()); }
+	}
+	if (opts.stats){
+		CompilationSession::Activation active(session);
+		session->stats().write(Report::errStream(), session->path());
+	}
+	return exitCode;
+}
+
+//The --stats-json objects of the inputs compiled so far, which
+// batch workers add to as they finish
+class StatsLog{
+public:
+	void add(CompilationSession * session){
+		std::ostringstream json;
+		{
+			CompilationSession::Activation active(session);
+			session->stats().writeJson(json, session->path());
+		}
+		std::lock_guard<std::mutex> guard(lock);
+		entries.emplace_back(session->path(), json.str());
+	}
+
+	//Write the objects out as an array, in input order
+	bool write(const char * outPath, 
+		const std::vector<std::string>& inFiles
+	){
+		std::unordered_map<std::string, size_t> order;
+		for (size_t i = inFiles.size(); i > 0; i--){
+			order[inFiles[i - 1]] = i - 1;
+		}
+		std::stable_sort(entries.begin(), entries.end(),
+			[&order](const Entry& a, const Entry& b){
+				return order[a.first] < order[b.first];
+			});
+		std::ofstream out(outPath);
+		if (!out.good()){ return false; }
+		out << "[";
+		for (size_t i = 0; i < entries.size(); i++){
+			out << (i == 0 ? "\n  " : ",\n  ") << entries[i].second;
+		}
+		out << "\n]\n";
+		return out.good();
+	}
+private:
+	using Entry = std::pair<std::string, std::string>;
+	std::mutex lock;
+	std::vector<Entry> entries;
+};
+
+//Write out the --stats-json and --trace files, if asked for
+static int writeReports(const Options& opts, StatsLog * log,
+	TraceLog * trace, const std::vector<std::string>& inFiles, 
+	int exitCode
+){
+	if (opts.statsJson != nullptr && !log->write(opts.statsJson, inFiles)){
+		Report::errStream() << "Bad output file " << opts.statsJson 
+		  << std::endl;
+		exitCode = 1;
+	}
+	if (opts.traceFile != nullptr && !trace->write(opts.traceFile)){
+		Report::errStream() << "Bad output file " << opts.traceFile 
+		  << std::endl;
+		exitCode = 1;
+	}
+	return exitCode;
+}
+
+int compileInputs(const Options& opts, 
+	const std::vector<std::string>& inFiles, SourceBuffer * source
+){
+	StatsLog log;
+	TraceLog trace;
+	TraceLog * tracing = opts.traceFile != nullptr ? &trace : nullptr;
+	TraceLog::Scope traceScope(tracing);
+	if (inFiles.size() > 1){
+		size_t jobs = opts.jobs;
+		if (jobs == 0){ jobs = std::thread::hardware_concurrency(); }
+		if (jobs == 0){ jobs = 1; }
+		Batch batch(inFiles, jobs);
+		int exitCode = batch.run(
+			[&opts, &log, tracing](CompilationSession * session){ 
+				TraceLog::Scope workerScope(tracing);
+				int code = compile(session, opts);
+				if (opts.statsJson != nullptr){ log.add(session); }
+				return code;
+			}, Report::outStream(), Report::errStream());
+		batch.summary(Report::errStream());
+		if (opts.cache != nullptr){ opts.cache->report(Report::errStream()); }
+		return writeReports(opts, &log, &trace, inFiles, exitCode);
+	}
+
+	const char * inFile = inFiles[0].c_str();
+	CompilationSession session(inFile, source);
+	if (!session.good()){
+		Report::errStream() << "Bad path " << inFile << std::endl;
+		usage(Report::errStream());
+		return 1;
+	}
+
+	CompilationSession::Activation active(&session);
+	int exitCode = compile(&session, opts);
+	if (opts.statsJson != nullptr){ log.add(&session); }
+	return writeReports(opts, &log, &trace, inFiles, exitCode);
+}
+
+} //End namespace cshanty
@@ -0,0 +1,65 @@
+#ifndef CSHANTY_DRIVER_HPP
+#define CSHANTY_DRIVER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "result_cache.hpp"
+#include "session.hpp"
+#include "source_buffer.hpp"
+
+namespace cshanty{
+
+//What to do with each input file, as given on the command line
+struct Options{
+	const char * tokensFile = nullptr;
+	bool checkParse = false;
+	const char * unparseFile = nullptr;
+	const char * namesFile = nullptr;
+	bool checkTypes = false;
+	const char * astFile = nullptr;
+	bool reportMemory = false;
+	//Report the cost of each phase, as a table and/or as JSON
+	// written to statsJson
+	bool stats = false;
+	const char * statsJson = nullptr;
+	//Where to write a trace of the compilation, if anywhere
+	const char * traceFile = nullptr;
+	//Which scanner to lex source input with
+	ScannerKind scanner = FLEX_SCANNER;
+	KernelSet scanKernels = bestKernels();
+	//Threads to lex each large input on, with the hand scanner
+	size_t lexThreads = 1;
+	//Lex on a thread of its own, overlapping with parsing
+	bool pipeline = false;
+	//Worker threads for compiling multiple inputs
+	size_t jobs = 0;
+	//Where to look up and store results, if anywhere
+	ResultCache * cache = nullptr;
+};
+
+void usage(std::ostream& out);
+
+//Read the phase flags and input files (expanding @fileList 
+// arguments) out of args. Returns false, having said why on 
+// err, if the arguments don't make sense. Options refer to the
+// strings in args, which must outlive them.
+bool parseOptions(const std::vector<std::string>& args, 
+	Options * opts, std::vector<std::string> * inFiles, 
+	std::ostream& err);
+
+//Run the requested phases on one (activated) session, or 
+// replay their results from the cache, and return the exit 
+// code for it
+int compile(CompilationSession * session, const Options& opts);
+
+//Compile the input files, in batch mode if there is more than
+// one, and return the exit code. If source is given, it is 
+// compiled in place of reading the (single) input file. All
+// output goes to the Report streams.
+int compileInputs(const Options& opts, 
+	const std::vector<std::string>& inFiles, SourceBuffer * source);
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef CSHANTY_SCAN_ERROR_REPORTING_HH
+#define CSHANTY_SCAN_ERROR_REPORTING_HH
+
+#include <string>
+#include "errors.hpp"
+
+namespace cshanty{
+
+//Lexical errors, shared by the flex scanner and the 
+// hand-written one so that they report identically
+class ScanErr{
+public:
+static void illegal(Position * pos, std::string match){
+	Report::fatal(pos, "Illegal character " + match);
+}
+static void strEsc(Position * pos){
+	Report::fatal(pos, "String literal with bad"
+	" escape sequence ignored");
+}
+static void strUnterm(Position * pos){
+	Report::fatal(pos, "Unterminated string"
+	" literal ignored");
+}
+static void strEscAndUnterm(Position * pos){
+	Report::fatal(pos, "Unterminated string literal"
+	" with bad escape sequence ignored");
+}
+static void intOverflow(Position * pos){
+	Report::fatal(pos, "Integer literal too large;"
+	" using max value");
+}
+};
+
+} //End namespace cshanty
+
+#endif
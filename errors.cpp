@@ -0,0 +1,29 @@
+#include "errors.hpp"
+
+namespace cshanty{
+
+static thread_local std::ostream * currentErr = nullptr;
+static thread_local std::ostream * currentOut = nullptr;
+
+std::ostream& Report::errStream(){
+	if (currentErr == nullptr){ return std::cerr; }
+	return *currentErr;
+}
+
+std::ostream& Report::outStream(){
+	if (currentOut == nullptr){ return std::cout; }
+	return *currentOut;
+}
+
+Report::Scope::Scope(std::ostream * err, std::ostream * out)
+: previousErr(currentErr), previousOut(currentOut){
+	currentErr = err;
+	currentOut = out;
+}
+
+Report::Scope::~Scope(){
+	currentErr = previousErr;
+	currentOut = previousOut;
+}
+
+} //End namespace cshanty
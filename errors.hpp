@@ -27,13 +27,31 @@ private:
 	const char * myMsg;
 };
 
+//Reports diagnostics for the current compilation. They go to
+// std::cerr (and other compiler output to std::cout) unless the
+// calling thread has installed other streams with a Scope, as
+// batch mode does to keep each file's messages together.
 class Report{
 public:
+	static std::ostream& errStream();
+	static std::ostream& outStream();
+
+	//Sends the calling thread's diagnostics to err and its 
+	// other output to out for the lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(std::ostream * err, std::ostream * out);
+		~Scope();
+	private:
+		std::ostream * previousErr;
+		std::ostream * previousOut;
+	};
+
 	static void fatal(
 		Position * pos,
 		const char * msg
 	){
-		std::cerr << "FATAL " 
+		errStream() << "FATAL " 
 		<< pos->span()
 		<< ": " 
 		<< msg  << std::endl;
@@ -50,7 +68,7 @@ public:
 		Position * pos,
 		const char * msg
 	){
-		std::cerr << "WARNING "
+		errStream() << "WARNING "
 		<< pos->span()
 		<< " " 
 		<< msg  << std::endl;
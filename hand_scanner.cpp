@@ -0,0 +1,379 @@
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include "errScan.hpp"
+#include "hand_scanner.hpp"
+#include "interner.hpp"
+#include "token_stream.hpp"
+
+namespace cshanty{
+
+using TokenKind = cshanty::Parser::token;
+
+namespace{
+
+//What a byte can start (or, for IDENT_BYTE and DIGIT_BYTE,
+// continue)
+enum ByteClass : unsigned char {
+	ILLEGAL_BYTE, SPACE_BYTE, NEWLINE_BYTE, CR_BYTE, IDENT_BYTE,
+	DIGIT_BYTE, QUOTE_BYTE, SLASH_BYTE, PUNCT_BYTE, OPERATOR_BYTE
+};
+
+//The class of every byte, and the token kind of each byte
+// that is a token by itself
+class ByteTable{
+public:
+	ByteTable(){
+		for (size_t i = 0; i < 256; i++){
+			classes[i] = ILLEGAL_BYTE;
+			kinds[i] = 0;
+		}
+		set(" \t", SPACE_BYTE);
+		set("\n", NEWLINE_BYTE);
+		set("\r", CR_BYTE);
+		set("abcdefghijklmnopqrstuvwxyz"
+		  "ABCDEFGHIJKLMNOPQRSTUVWXYZ_", IDENT_BYTE);
+		set("0123456789", DIGIT_BYTE);
+		set("\"", QUOTE_BYTE);
+		set("/", SLASH_BYTE);
+		set("+-&|=!<>", OPERATOR_BYTE);
+		punct('[', TokenKind::LBRACE);
+		punct(']', TokenKind::RBRACE);
+		punct('{', TokenKind::OPEN);
+		punct('}', TokenKind::CLOSE);
+		punct('(', TokenKind::LPAREN);
+		punct(')', TokenKind::RPAREN);
+		punct(';', TokenKind::SEMICOL);
+		punct(',', TokenKind::COMMA);
+		punct('*', TokenKind::TIMES);
+	}
+	ByteClass byteClass(char c) const {
+		return classes[static_cast<unsigned char>(c)];
+	}
+	int kind(char c) const {
+		return kinds[static_cast<unsigned char>(c)];
+	}
+private:
+	void set(const char * bytes, ByteClass byteClass){
+		for (const char * c = bytes; *c != '\0'; c++){
+			classes[static_cast<unsigned char>(*c)] = byteClass;
+		}
+	}
+	void punct(char c, int kind){
+		classes[static_cast<unsigned char>(c)] = PUNCT_BYTE;
+		kinds[static_cast<unsigned char>(c)] = kind;
+	}
+	ByteClass classes[256];
+	int kinds[256];
+};
+
+const ByteTable BYTES;
+
+struct Keyword{
+	const char * word;
+	int kind;
+	//If word is the first word of a multi-word synonym, the
+	// whole synonym, which is what lexes as kind. Otherwise
+	// nullptr.
+	const char * phrase;
+};
+
+const Keyword KEYWORDS[] = {
+	{"int", TokenKind::INT, nullptr},
+	{"bool", TokenKind::BOOL, nullptr},
+	{"record", TokenKind::RECORD, nullptr},
+	{"string", TokenKind::STRING, nullptr},
+	{"void", TokenKind::VOID, nullptr},
+	{"if", TokenKind::IF, nullptr},
+	{"else", TokenKind::ELSE, nullptr},
+	{"while", TokenKind::WHILE, nullptr},
+	{"return", TokenKind::RETURN, nullptr},
+	{"false", TokenKind::FALSE, nullptr},
+	{"nay", TokenKind::FALSE, nullptr},
+	{"true", TokenKind::TRUE, nullptr},
+	{"aye", TokenKind::TRUE, nullptr},
+	{"report", TokenKind::REPORT, nullptr},
+	{"receive", TokenKind::RECEIVE, nullptr},
+	{"ahoy", TokenKind::OPEN, nullptr},
+	{"plus", TokenKind::PLUS, nullptr},
+	{"minus", TokenKind::MINUS, nullptr},
+	{"times", TokenKind::TIMES, nullptr},
+	{"divide", TokenKind::DIVIDE, nullptr},
+	{"and", TokenKind::AND, nullptr},
+	{"or", TokenKind::OR, nullptr},
+	{"equals", TokenKind::EQUALS, nullptr},
+	{"gets", TokenKind::ASSIGN, nullptr},
+	{"we", TokenKind::RETURN, "we'll take our leave and go"},
+	{"shove", TokenKind::CLOSE, "shove off"},
+	{"heave", TokenKind::SEMICOL, "heave and go"},
+	{"roll", TokenKind::SEMICOL, "roll and go"},
+};
+
+//A perfect hash of the keywords, on their length and first
+// and last bytes
+class KeywordTable{
+public:
+	KeywordTable(){
+		for (size_t i = 0; i < SLOTS; i++){ slots[i] = Slot{nullptr, 0}; }
+		for (const Keyword& keyword : KEYWORDS){
+			size_t len = strlen(keyword.word);
+			Slot& slot = slots[hash(keyword.word, len)];
+			if (slot.keyword != nullptr){
+				throw new InternalError("Keyword hash collision");
+			}
+			slot = Slot{&keyword, len};
+		}
+	}
+	//The keyword that the len bytes at word spell, if any
+	const Keyword * find(const char * word, size_t len) const {
+		const Slot& slot = slots[hash(word, len)];
+		if (slot.len != len){ return nullptr; }
+		if (memcmp(slot.keyword->word, word, len) != 0){ return nullptr; }
+		return slot.keyword;
+	}
+private:
+	static const size_t SLOTS = 64;
+	static size_t hash(const char * word, size_t len){
+		size_t first = static_cast<unsigned char>(word[0]);
+		size_t last = static_cast<unsigned char>(word[len - 1]);
+		return (11 * first + 2 * last + len) & (SLOTS - 1);
+	}
+	struct Slot{
+		const Keyword * keyword;
+		size_t len;
+	};
+	Slot slots[SLOTS];
+};
+
+const KeywordTable& keywords(){
+	static const KeywordTable table;
+	return table;
+}
+
+//An illegal byte as the flex scanner reports it, from yytext 
+// as a C string: a NUL byte is reported as nothing at all
+std::string illegalMatch(char c){
+	return c == '\0' ? std::string() : std::string(1, c);
+}
+
+}
+
+void HandScanner::tokenize(TokenStream * stream){
+	while (yylex(stream) != TokenKind::END){ }
+	finish(stream);
+}
+
+int HandScanner::yylex(TokenStream * stream){
+	while (cursor < size){
+		size_t start = cursor;
+		char c = data[start];
+		switch (BYTES.byteClass(c)){
+		case SPACE_BYTE:
+		case NEWLINE_BYTE:
+			cursor = skipSpace(kernels, data, start, size,
+				&lineNum, &lineStart);
+			break;
+		case CR_BYTE:
+			if (start + 1 >= size || data[start + 1] != '\n'){
+				Position pos(start, start + 1);
+				ScanErr::illegal(&pos, illegalMatch(c));
+				cursor++;
+				break;
+			}
+			//\r\n is a newline, like \n
+			cursor += 2;
+			lineNum++;
+			lineStart = cursor;
+			break;
+		case IDENT_BYTE:
+			return identifier(stream, start);
+		case DIGIT_BYTE:
+			return intLiteral(stream, start);
+		case QUOTE_BYTE:
+			if (strLiteral(stream, start)){ return TokenKind::STRLITERAL; }
+			break;
+		case SLASH_BYTE:
+			if (start + 1 < size && data[start + 1] == '/'){
+				//A comment, up to (but not including) the newline
+				cursor = lineEnd(kernels, data, start + 2, size);
+				break;
+			}
+			return bareToken(stream, TokenKind::DIVIDE, start, 1);
+		case PUNCT_BYTE:
+			return bareToken(stream, BYTES.kind(c), start, 1);
+		case OPERATOR_BYTE: {
+			//The token c is by itself (0 if none), and the token
+			// it makes followed by second
+			int single = 0;
+			char second = '=';
+			int pair = 0;
+			switch (c){
+			case '+': single = TokenKind::PLUS; second = '+';
+				pair = TokenKind::INC; break;
+			case '-': single = TokenKind::MINUS; second = '-';
+				pair = TokenKind::DEC; break;
+			case '&': second = '&'; pair = TokenKind::AND; break;
+			case '|': second = '|'; pair = TokenKind::OR; break;
+			case '=': single = TokenKind::ASSIGN;
+				pair = TokenKind::EQUALS; break;
+			case '!': single = TokenKind::NOT;
+				pair = TokenKind::NOTEQUALS; break;
+			case '<': single = TokenKind::LESS;
+				pair = TokenKind::LESSEQ; break;
+			default: single = TokenKind::GREATER;
+				pair = TokenKind::GREATEREQ; break;
+			}
+			if (start + 1 < size && data[start + 1] == second){
+				return bareToken(stream, pair, start, 2);
+			}
+			if (single != 0){ return bareToken(stream, single, start, 1); }
+			Position pos(start, start + 1);
+			ScanErr::illegal(&pos, illegalMatch(c));
+			cursor++;
+			break;
+		}
+		default: {
+			Position pos(start, start + 1);
+			ScanErr::illegal(&pos, illegalMatch(c));
+			cursor++;
+			break;
+		}
+		}
+	}
+	return TokenKind::END;
+}
+
+int HandScanner::bareToken(TokenStream * stream, int kind,
+	size_t start, size_t len
+){
+	cursor = start + len;
+	stream->append(kind, start, cursor);
+	return kind;
+}
+
+int HandScanner::identifier(TokenStream * stream, size_t start){
+	size_t end = identEnd(kernels, data, start + 1, size);
+	size_t len = end - start;
+
+	const Keyword * keyword = keywords().find(data + start, len);
+	if (keyword != nullptr){
+		if (keyword->phrase == nullptr){
+			return bareToken(stream, keyword->kind, start, len);
+		}
+		//A multi-word synonym is always longer than its first
+		// word, so it wins whenever it is there
+		size_t phraseLen = strlen(keyword->phrase);
+		if (phraseLen <= size - start
+		  && memcmp(data + start, keyword->phrase, phraseLen) == 0){
+			return bareToken(stream, keyword->kind, start, phraseLen);
+		}
+	}
+
+	cursor = end;
+	stream->append(TokenKind::ID, start, end,
+		Interner::current()->intern(data + start, len));
+	return TokenKind::ID;
+}
+
+int HandScanner::intLiteral(TokenStream * stream, size_t start){
+	size_t significant = start;
+	while (significant < size && data[significant] == '0'){
+		significant++;
+	}
+	size_t end = significant;
+	while (end < size && BYTES.byteClass(data[end]) == DIGIT_BYTE){
+		end++;
+	}
+
+	//Too large if it has more than 10 digits after any leading
+	// zeros, as in the flex scanner
+	bool overflow = end - significant > 10;
+	uint64_t value = 0;
+	if (!overflow){
+		for (size_t i = significant; i < end; i++){
+			value = value * 10 + static_cast<uint64_t>(data[i] - '0');
+		}
+		overflow = value > INT_MAX;
+	}
+	cursor = end;
+	Position pos(start, end);
+	if (overflow){
+		ScanErr::intOverflow(&pos);
+		value = INT_MAX;
+	}
+	stream->append(TokenKind::INTLITERAL, start, end,
+		static_cast<uint32_t>(value));
+	return TokenKind::INTLITERAL;
+}
+
+bool HandScanner::strLiteral(TokenStream * stream, size_t start){
+	//The flex scanner has five rules for strings. The first two
+	// match a good string and a good but unterminated one:
+	// escapes (\n, \t, \" and \\) or bytes other than \, " and
+	// newline, closed by a " or not.
+	size_t good = start + 1;
+	while (good < size){
+		char c = data[good];
+		if (c == '\\'){
+			if (good + 1 >= size){ break; }
+			char escapee = data[good + 1];
+			if (escapee != 'n' && escapee != 't'
+			  && escapee != '"' && escapee != '\\'){
+				break;
+			}
+			good += 2;
+		} else if (c == '"' || c == '\n'){
+			break;
+		} else {
+			good++;
+		}
+	}
+	bool closed = good < size && data[good] == '"';
+
+	//The other three match any run of bytes other than " and
+	// newline that has a backslash in it, followed by nothing, 
+	// by a backslash (which the run would have taken anyway), by
+	// \" or by ".
+	size_t run = start + 1;
+	size_t firstSlash = SIZE_MAX;
+	while (run < size && data[run] != '"' && data[run] != '\n'){
+		if (data[run] == '\\' && firstSlash == SIZE_MAX){
+			firstSlash = run;
+		}
+		run++;
+	}
+	bool atQuote = run < size && data[run] == '"';
+	bool hasSlash = firstSlash != SIZE_MAX;
+	bool slashQuote = atQuote && hasSlash && firstSlash < run - 1
+		&& data[run - 1] == '\\';
+
+	//Take the longest match, and the earliest rule on a tie
+	size_t end = good;
+	void (*error)(Position *) = ScanErr::strUnterm;
+	if (closed){
+		end = good + 1;
+		error = nullptr;
+	}
+	if (hasSlash && run > end){
+		end = run;
+		error = ScanErr::strEscAndUnterm;
+	}
+	if (slashQuote && run + 1 > end){
+		end = run + 1;
+		error = ScanErr::strEscAndUnterm;
+	} else if (atQuote && hasSlash && run + 1 > end){
+		end = run + 1;
+		error = ScanErr::strEsc;
+	}
+
+	cursor = end;
+	Position pos(start, end);
+	if (error != nullptr){
+		error(&pos);
+		return false;
+	}
+	stream->append(TokenKind::STRLITERAL, start, end);
+	return true;
+}
+
+} //End namespace cshanty
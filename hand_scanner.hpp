@@ -0,0 +1,67 @@
+#ifndef CSHANTY_HAND_SCANNER_HPP
+#define CSHANTY_HAND_SCANNER_HPP
+
+#include <algorithm>
+#include "grammar.hh"
+#include "scan_kernels.hpp"
+#include "source_buffer.hpp"
+#include "token_stream.hpp"
+
+namespace cshanty{
+
+//A hand-written scanner for the language of cshanty.l, which
+// produces exactly the tokens (and lexical errors) that the
+// flex scanner does, without going through yyFlexLexer. Each
+// byte is classified through a table, keywords and the first
+// words of the multi-word synonyms are recognized with a
+// perfect hash, and tokens are appended straight to the
+// TokenStream. As in flex, where rules overlap the
+// longest match wins, and the earliest rule on a tie. Runs of
+// whitespace, comments and identifiers are measured with the
+// given kernels, or the best this CPU supports if it can't
+// run them.
+class HandScanner{
+public:
+	HandScanner(SourceBuffer * sourceIn,
+		KernelSet kernelsIn = bestKernels())
+	: HandScanner(sourceIn, 0, sourceIn->size(), kernelsIn){ }
+	//Lex only the bytes from begin up to end, which must start
+	// a line. Line numbers count from 1 at begin.
+	HandScanner(SourceBuffer * sourceIn, size_t begin, size_t end,
+		KernelSet kernelsIn = bestKernels())
+	: mySource(sourceIn), data(sourceIn->data()),
+	  size(end), cursor(begin), lineNum(1),
+	  lineStart(begin), kernels(std::min(kernelsIn, bestKernels())){ }
+
+	//Lex the next token, appending it to stream, in the same
+	// manner as Scanner::yylex. Once the input is exhausted,
+	// END is returned.
+	int yylex(TokenStream * stream);
+
+	//Lex the entire input, appending every token to stream
+	void tokenize(TokenStream * stream);
+	//Once yylex has returned END, record the end of the input
+	// in stream
+	void finish(TokenStream * stream){
+		stream->setEnd(lineNum, size - lineStart + 1);
+	}
+private:
+	int bareToken(TokenStream * stream, int kind,
+		size_t start, size_t len);
+	int identifier(TokenStream * stream, size_t start);
+	int intLiteral(TokenStream * stream, size_t start);
+	//Returns false if the string was bad, and so not a token
+	bool strLiteral(TokenStream * stream, size_t start);
+
+	SourceBuffer * mySource;
+	const char * data;
+	size_t size;       //Byte offset of the end of the input
+	size_t cursor;     //Byte offset of the next unlexed byte
+	size_t lineNum;
+	size_t lineStart;  //Byte offset of the current line
+	KernelSet kernels;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,47 @@
+#include <cstring>
+#include "interner.hpp"
+
+namespace cshanty{
+
+static thread_local Interner * currentInterner = nullptr;
+
+bool Interner::Key::operator==(const Key& other) const{
+	return len == other.len && memcmp(text, other.text, len) == 0;
+}
+
+//FNV-1a, which is cheap for the short strings identifiers 
+// usually are
+size_t Interner::KeyHash::operator()(const Key& key) const{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < key.len; i++){
+		hash ^= static_cast<unsigned char>(key.text[i]);
+		hash *= 1099511628211ULL;
+	}
+	return static_cast<size_t>(hash);
+}
+
+SymbolId Interner::intern(const char * text, size_t len){
+	Key probe{text, len};
+	auto found = ids.find(probe);
+	if (found != ids.end()){ return found->second; }
+
+	SymbolId id = static_cast<SymbolId>(strings.size());
+	strings.emplace_back(text, len);
+	const std::string& copy = strings.back();
+	ids.emplace(Key{copy.data(), copy.size()}, id);
+	return id;
+}
+
+Interner * Interner::current(){
+	return currentInterner;
+}
+
+Interner::Scope::Scope(Interner * interner) : previous(currentInterner){
+	currentInterner = interner;
+}
+
+Interner::Scope::~Scope(){
+	currentInterner = previous;
+}
+
+} //End namespace cshanty
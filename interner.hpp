@@ -0,0 +1,57 @@
+#ifndef CSHANTY_INTERNER_HPP
+#define CSHANTY_INTERNER_HPP
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+
+namespace cshanty{
+
+//A dense integer standing for one distinct identifier
+using SymbolId = uint32_t;
+
+//Maps every distinct identifier in a compilation to a dense 
+// SymbolId, keeping exactly one copy of its text. Identifiers
+// are interned as they are lexed, so that later phases hash and
+// compare integers rather than strings.
+class Interner{
+public:
+	SymbolId intern(const char * text, size_t len);
+	SymbolId intern(const std::string& text){
+		return intern(text.data(), text.size());
+	}
+	const std::string& str(SymbolId id) const { return strings[id]; }
+	size_t size() const { return strings.size(); }
+
+	//The interner that identifiers seen by this thread are 
+	// interned in
+	static Interner * current();
+
+	//Makes an interner current for the calling thread for 
+	// the lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(Interner * interner);
+		~Scope();
+	private:
+		Interner * previous;
+	};
+private:
+	//A key refers either to the text being looked up or to
+	// the interned copy in strings (whose storage never moves)
+	struct Key{
+		const char * text;
+		size_t len;
+		bool operator==(const Key& other) const;
+	};
+	struct KeyHash{
+		size_t operator()(const Key& key) const;
+	};
+	std::unordered_map<Key, SymbolId, KeyHash> ids;
+	std::deque<std::string> strings;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -1,213 +1,39 @@
 #include <iostream>
 #include <cstdlib>
 #include <cstring>
-#include <fstream>
-#include "errors.hpp"
-#include "scanner.hpp"
-#include "name_analysis.hpp"
-#include "type_analysis.hpp"
+#include <string>
+#include <vector>
+#include "driver.hpp"
+#include "server.hpp"
 
 using namespace cshanty;
 
 static void usageAndDie(){
-	std::cerr << "Usage: cshantyc <infile>\n"
-	<< " [-c]: Do type checking\n"
-	<< " [-n <nameFile>]: Perform name analysis\n"
-	<< " [-u <unparseFile>]: Output canonical program form\n"
-	<< " [-p]: Parse the input to check syntax\n"
-	<< " [-t <tokensFile>]: Output tokens to <tokensFile>\n"
-	;
+	usage(std::cerr);
 	exit(1);
 }
 
-static void writeTokenStream(const char * inPath, const char * outPath){
-	std::ifstream inStream(inPath);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream";
-		msg += inPath;
-		throw new cshanty::InternalError(msg.c_str());
-	}
-	if (outPath == nullptr){
-		std::string msg = "No tokens output file given";
-		throw new cshanty::InternalError(msg.c_str());
-	}
-
-	Scanner scanner(&inStream);
-	if (strcmp(outPath, "--") == 0){
-		scanner.outputTokens(std::cout);
-	} else {
-		std::ofstream outStream(outPath);
-		if (!outStream.good()){
-			std::string msg = "Bad output file ";
-			msg += outPath;
-			throw new InternalError(msg.c_str());
-		}
-		scanner.outputTokens(outStream);
-		outStream.close();
-	}
-}
-
-static cshanty::ProgramNode * parse(const char * inFile){
-	std::ifstream inStream(inFile);
-	if (!inStream.good()){
-		std::string msg = "Bad input stream ";
-		msg += inFile;
-		throw new InternalError(msg.c_str());
-	}
-
-	//This pointer will be set to the root of the
-	// AST after parsing
-	cshanty::ProgramNode * root = nullptr;
-
-	cshanty::Scanner scanner(&inStream);
-	cshanty::Parser parser(scanner, &root);
-
-	int errCode = parser.parse();
-	if (errCode != 0){ return nullptr; }
-
-	return root;
-}
-
-static void outputAST(ASTNode * ast, const char * outPath){
-	if (strcmp(outPath, "--") == 0){
-		ast->unparse(std::cout, 0);
-	} else {
-		std::ofstream outStream(outPath);
-		if (!outStream.good()){
-			std::string msg = "Bad output file ";
-			msg += outPath;
-			throw new cshanty::InternalError(msg.c_str());
-		}
-		ast->unparse(outStream, 0);
-	}
-}
-
-static cshanty::NameAnalysis * doNameAnalysis(const char * inputPath){
-	cshanty::ProgramNode * ast = parse(inputPath);
-	if (ast == nullptr){ return nullptr; }
-	
-	return cshanty::NameAnalysis::build(ast);
-}
-
-static bool doUnparsing(const char * inputPath, const char * outPath){
-	cshanty::ProgramNode * ast = parse(inputPath);
-	if (ast == nullptr){ 
-		std::cerr << "No AST built\n";
-		return false;
-	}
-
-	outputAST(ast, outPath);
-	return true;
-}
-
-static cshanty::TypeAnalysis * doTypeAnalysis(const char * inputPath){
-	cshanty::NameAnalysis * nameAnalysis = doNameAnalysis(inputPath);
-	if (nameAnalysis == nullptr){ return nullptr; }
-	return TypeAnalysis::build(nameAnalysis);
-}
-
 int 
 main( const int argc, const char **argv )
 {
 	if (argc <= 1){ usageAndDie(); }
-	std::ifstream * input = new std::ifstream(argv[1]);
-	if (input == nullptr){ usageAndDie(); }
-	if (!input->good()){
-		std::cerr << "Bad path " << argv[1] << std::endl;
-		usageAndDie();
-	}
 
-	const char * inFile = NULL;
-	const char * tokensFile = NULL;
-	bool checkParse = false;
-	const char * unparseFile = NULL;
-	const char * namesFile = NULL;
-	bool checkTypes = false;
-
-	bool useful = false;
-	int i = 1;
-	for (int i = 1 ; i < argc ; i++){
-		if (argv[i][0] == '-'){
-			if (argv[i][1] == 't'){
-				i++;
-				tokensFile = argv[i];
-				useful = true;
-			} else if (argv[i][1] == 'p'){
-				checkParse = true;
-				useful = true;
-			} else if (argv[i][1] == 'u'){
-				i++;
-				if (i >= argc){ usageAndDie(); }
-				unparseFile = argv[i];
-				useful = true;
-			} else if (argv[i][1] == 'n'){
-				i++;
-				namesFile = argv[i];
-				useful = true;
-			} else if (argv[i][1] == 'c'){
-				checkTypes = true;
-				useful = true;
-			} else {
-				std::cerr << "Unrecognized argument: ";
-				std::cerr << argv[i] << std::endl;
-				usageAndDie();
-			}
-		} else {
-			if (inFile == NULL){
-				inFile = argv[i];
-			} else {
-				std::cerr << "Only 1 input file allowed";
-				std::cerr << argv[i] << std::endl;
-				usageAndDie();
-			}
-		}
-	}
-	if (inFile == NULL){
-		usageAndDie();
+	if (strcmp(argv[1], "--server") == 0){
+		if (argc != 3){ usageAndDie(); }
+		CompileServer server(argv[2]);
+		return server.serve();
 	}
-	if (!useful){
-		std::cerr << "Hey, you didn't tell cshantyc to do anything!\n";
-		usageAndDie();
+	if (strcmp(argv[1], "--client") == 0){
+		if (argc < 4){ usageAndDie(); }
+		std::vector<std::string> args(argv + 3, argv + argc);
+		return runClient(argv[2], args);
 	}
 
-	try {
-		if (tokensFile != nullptr){
-			writeTokenStream(inFile, tokensFile);
-		}
-		if (checkParse){
-			if (!parse(inFile)){
-				std::cerr << "Parse failed" << std::endl;
-			}
-		}
-		if (unparseFile != nullptr){
-			doUnparsing(inFile, unparseFile);
-		}
-		if (namesFile){
-			cshanty::NameAnalysis * na;
-			na = doNameAnalysis(inFile);
-			if (na == nullptr){
-				std::cerr << "Name Analysis Failed\n";
-				return 1;
-			}
-			outputAST(na->ast, namesFile);
-		}
-		if (checkTypes){
-			cshanty::TypeAnalysis * ta;
-			ta = doTypeAnalysis(inFile);
-			if (ta == nullptr){
-				std::cerr << "Type Analysis Failed\n";
-				return 1;
-			} else {
-				std::cout << "Great job! Type analysis succeeded\n";
-			}
-		}
-	} catch (cshanty::ToDoError * e){
-		std::cerr << "ToDoError: " << e->msg() << "\n";
-		return 1;
-	} catch (cshanty::InternalError * e){
-		std::cerr << "InternalError: " << e->msg() << "\n";
-		return 1;
+	std::vector<std::string> args(argv + 1, argv + argc);
+	Options opts;
+	std::vector<std::string> inFiles;
+	if (!parseOptions(args, &opts, &inFiles, std::cerr)){
+		usageAndDie();
 	}
-
-	return 0;
+	return compileInputs(opts, inFiles, nullptr);
 }
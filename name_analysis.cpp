@@ -3,6 +3,8 @@
 #include "errName.hpp"
 #include "types.hpp"
 #include "name_analysis.hpp"
+#include "trace.hpp"
+#include "type_context.hpp"
 
 namespace cshanty{
 
@@ -80,7 +82,7 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	bool checkType = myType->nameAnalysis(symTab);
 
 	const DataType * dataType = getTypeNode()->getType();
-	std::string varName = ID()->getName();
+	SymbolId varName = ID()->getId();
 
 	bool validType = true;
 	if (dataType == nullptr){
@@ -99,7 +101,9 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 	if (!checkType || !validType || !validName){ 
 		return false; 
 	} else {
-		symTab->insert(new VarSymbol(varName, dataType));
+		VarSymbol * var = new VarSymbol(varName, dataType);
+		var->setCoord(symTab->allocSlot());
+		symTab->insert(var);
 		SemSymbol * sym = symTab->find(varName);
 		this->myID->attachSymbol(sym);
 		return true;
@@ -107,17 +111,18 @@ bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool RecordTypeDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string name = myID->getName();
+	TraceSpan span("names", "record", myID->getName());
+	SymbolId name = myID->getId();
 	if (symTab->find(name) != nullptr){
 		NameErr::multiDecl(this->pos());
 		return false;
 	}
 
-	auto fields = new HashMap<std::string, const DataType *>();
+	HashMap<SymbolId, const DataType *> fields;
 	SymbolTable t;
 	t.enterScope();
 	for(auto elt : *myFields){
-		std::string fieldName = elt->ID()->getName();
+		SymbolId fieldName = elt->ID()->getId();
 		SemSymbol * sym = t.find(fieldName);
 		if (sym != nullptr){
 			NameErr::multiDecl(elt->pos());
@@ -130,18 +135,25 @@ bool RecordTypeDeclNode::nameAnalysis(SymbolTable * symTab){
 			NameErr::badVarType(elt->pos()); 
 			return false;
 		}
-		(*fields)[fieldName] = sym->getDataType();
+		//The temporary table numbered the field as though it
+		// were a global; it is the record's next field instead
+		static_cast<VarSymbol *>(sym)->setCoord(SymbolCoord(
+			SymbolCoord::FIELD_DEPTH, static_cast<uint32_t>(fields.size())));
+		elt->ID()->attachSymbol(sym);
+		fields[fieldName] = sym->getDataType();
 		t.addVar(fieldName, sym->getDataType());
 	}
 	t.leaveScope();
-	RecordType * r = RecordType::produce(myID->getName(), fields);
+	const RecordType * r = TypeContext::current()->recordType(
+		myID->getName(), std::move(fields));
 	symTab->insert(new RecordSymbol(name, r));
 
 	return true;
 }
 
 bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
-	std::string fnName = this->ID()->getName();
+	TraceSpan span("names", "fn", myID->getName());
+	SymbolId fnName = this->ID()->getId();
 
 	bool validRet = myRetType->nameAnalysis(symTab);
 
@@ -149,6 +161,7 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 	ScopeTable * atFnScope = symTab->getCurrentScope();
 	//Enter a new scope for "within" this function.
 	ScopeTable * inFnScope = symTab->enterScope();
+	symTab->beginFrame();
 
 	/*Note that we check for a clash of the function 
 	  name in it's declared scope (e.g. a global
@@ -161,18 +174,19 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 	}
 
 	bool validFormals = true;
-	std::list<const DataType *> * formalTypes = 
-		new std::list<const DataType *>();
+	std::vector<const DataType *> formalTypes;
+	formalTypes.reserve(myFormals->size());
 	for (auto formal : *(this->myFormals)){
 		validFormals = formal->nameAnalysis(symTab) && validFormals;
 		TypeNode * typeNode = formal->getTypeNode();
 		const DataType * formalType = typeNode->getType();
-		formalTypes->push_back(formalType);
+		formalTypes.push_back(formalType);
 	}
 
 
 	const DataType * retType = this->getRetTypeNode()->getType();
-	FnType * dataType = new FnType(formalTypes, retType);
+	const FnType * dataType = 
+		TypeContext::current()->fnType(formalTypes, retType);
 	//Make sure the fnSymbol is in the symbol table before 
 	// analyzing the body, to allow for recursive calls
 	if (validName){
@@ -187,6 +201,11 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 		validBody = stmt->nameAnalysis(symTab) && validBody;
 	}
 
+	if (validName){
+		FnSymbol * fnSym = static_cast<FnSymbol *>(myID->getSymbol());
+		fnSym->setFrameSize(symTab->frameSize());
+	}
+
 	symTab->leaveScope();
 	return (validRet && validFormals && validName && validBody);
 }
@@ -243,7 +262,7 @@ bool TypeNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool RecordTypeNode::nameAnalysis(SymbolTable * symTab){
-	SemSymbol * sym = symTab->find(myID->getName());
+	SemSymbol * sym = symTab->find(myID->getId());
 	if (sym == nullptr){
 		NameErr::badVarType(this->pos());
 		return false;
@@ -276,7 +295,7 @@ bool FalseNode::nameAnalysis(SymbolTable * symTab){
 }
 
 bool IDNode::nameAnalysis(SymbolTable* symTab){
-	std::string myName = this->getName();
+	SymbolId myName = this->getId();
 	SemSymbol * sym = symTab->find(myName);
 	if (sym == nullptr){
 		return NameErr::undeclID(pos());
@@ -287,6 +306,9 @@ bool IDNode::nameAnalysis(SymbolTable* symTab){
 
 void IDNode::attachSymbol(SemSymbol * symbolIn){
 	this->mySymbol = symbolIn;
+	if (symbolIn->getKind() == VAR){
+		this->myCoord = static_cast<VarSymbol *>(symbolIn)->getCoord();
+	}
 }
 
 }
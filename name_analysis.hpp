@@ -8,20 +8,29 @@ namespace cshanty{
 
 class NameAnalysis{
 public:
-	static NameAnalysis * build(ProgramNode * astIn){
-		NameAnalysis * nameAnalysis = new NameAnalysis;
+	//If statsOut is given, the symbol table's counters are
+	// copied there, whether or not the analysis succeeds
+	static NameAnalysis * build(ProgramNode * astIn, 
+		SymbolTableStats * statsOut = nullptr
+	){
 		SymbolTable * symTab = new SymbolTable();
 		bool res = astIn->nameAnalysis(symTab);
+		size_t globals = symTab->globalCount();
+		if (statsOut != nullptr){ *statsOut = symTab->stats(); }
 		delete symTab;
 		if (!res){ return nullptr; }
 
+		NameAnalysis * nameAnalysis = new NameAnalysis;
 		nameAnalysis->ast = astIn;
+		nameAnalysis->globalCount = globals;
 		return nameAnalysis;
 	}
 	ProgramNode * ast;
+	//The number of global slots handed out
+	size_t globalCount;
 
 private:
-	NameAnalysis(){
+	NameAnalysis() : ast(nullptr), globalCount(0){
 	}
 };
 
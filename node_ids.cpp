@@ -0,0 +1,27 @@
+#include "node_ids.hpp"
+
+namespace cshanty{
+
+static thread_local NodeIds * currentIds = nullptr;
+static thread_local NodeIds fallbackIds;
+
+NodeIds * NodeIds::current(){
+	return currentIds;
+}
+
+NodeId NodeIds::nextCurrent(){
+	if (currentIds == nullptr){
+		return fallbackIds.next();
+	}
+	return currentIds->next();
+}
+
+NodeIds::Scope::Scope(NodeIds * ids) : previous(currentIds){
+	currentIds = ids;
+}
+
+NodeIds::Scope::~Scope(){
+	currentIds = previous;
+}
+
+} //End namespace cshanty
@@ -0,0 +1,83 @@
+#ifndef CSHANTY_NODE_IDS_HPP
+#define CSHANTY_NODE_IDS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cshanty{
+
+//A dense integer identifying one AST node of a compilation
+using NodeId = uint32_t;
+
+//Hands out NodeIds, in order, to the AST nodes of one 
+// compilation, so that facts about nodes can be kept in flat
+// vectors (see NodeMap) instead of maps keyed by pointer.
+class NodeIds{
+public:
+	NodeIds() : count(0){ }
+	NodeId next(){ return count++; }
+	//The number of IDs handed out so far
+	size_t size() const { return count; }
+
+	//The counter that nodes created by this thread take their
+	// IDs from, or nullptr if there is none
+	static NodeIds * current();
+
+	//Take an ID from the current counter, or from a per-thread
+	// fallback counter if this thread has no current one
+	static NodeId nextCurrent();
+
+	//Makes a counter current for the calling thread for the 
+	// lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(NodeIds * ids);
+		~Scope();
+	private:
+		NodeIds * previous;
+	};
+private:
+	NodeId count;
+};
+
+//A fact of type T about each AST node, stored in a vector
+// indexed by NodeId. Nodes that were never given a value map
+// to the map's empty value. N is any type with a NodeId 
+// nodeId() member (i.e., ASTNode).
+template <typename N, typename T>
+class NodeMap{
+public:
+	NodeMap(T emptyIn) : empty(emptyIn), entries(0){ }
+
+	//Make room for the given number of nodes up front
+	void reserve(size_t nodes){ 
+		if (nodes > vals.size()){ vals.resize(nodes, empty); }
+	}
+
+	void set(const N * node, T val){
+		NodeId id = node->nodeId();
+		if (id >= vals.size()){ 
+			vals.resize((static_cast<size_t>(id) + 1) * 2, empty);
+		}
+		if (vals[id] == empty){ entries++; }
+		if (val == empty){ entries--; }
+		vals[id] = val;
+	}
+
+	T get(const N * node) const {
+		NodeId id = node->nodeId();
+		if (id >= vals.size()){ return empty; }
+		return vals[id];
+	}
+	//The number of nodes that map to something other than empty
+	size_t size() const { return entries; }
+private:
+	T empty;
+	std::vector<T> vals;
+	size_t entries;
+};
+
+} //End namespace cshanty
+
+#endif
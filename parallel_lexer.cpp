@@ -0,0 +1,137 @@
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "errors.hpp"
+#include "hand_scanner.hpp"
+#include "interner.hpp"
+#include "parallel_lexer.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+
+namespace cshanty{
+
+using TokenKind = cshanty::Parser::token;
+
+namespace{
+
+//What lexing one chunk of the input left behind
+struct Chunk{
+	Chunk(const SourceBuffer * source) : tokens(source){ }
+	size_t begin;
+	size_t end;
+	Interner interner;
+	TokenStream tokens;
+	std::ostringstream errors;
+};
+
+//The offsets at which to cut the input: each chunk starts
+// just after a newline, or at the start of the input
+std::vector<size_t> cuts(const char * data, size_t size,
+	size_t threads, size_t minChunk
+){
+	size_t target = size / (threads > 0 ? threads : 1);
+	if (target < minChunk){ target = minChunk; }
+	std::vector<size_t> result;
+	result.push_back(0);
+	size_t pos = 0;
+	while (size - pos > target){
+		const void * newline = memchr(data + pos + target, '\n',
+			size - pos - target);
+		if (newline == nullptr){ break; }
+		pos = static_cast<size_t>(
+			static_cast<const char *>(newline) - data) + 1;
+		if (pos >= size){ break; }
+		result.push_back(pos);
+	}
+	result.push_back(size);
+	return result;
+}
+
+}
+
+void ParallelLexer::tokenize(TokenStream * stream){
+	const char * data = source->data();
+	size_t size = source->size();
+	std::vector<size_t> bounds = cuts(data, size, threads, minChunk);
+	size_t count = bounds.size() - 1;
+	if (count <= 1){
+		HandScanner scanner(source, kernels);
+		scanner.tokenize(stream);
+		return;
+	}
+
+	std::vector<std::unique_ptr<Chunk>> chunks;
+	for (size_t i = 0; i < count; i++){
+		chunks.emplace_back(new Chunk(source));
+		chunks[i]->begin = bounds[i];
+		chunks[i]->end = bounds[i + 1];
+	}
+
+	TraceLog * trace = TraceLog::current();
+	std::atomic<size_t> nextChunk(0);
+	auto work = [&](){
+		TraceLog::Scope traced(trace);
+		while (true){
+			size_t index = nextChunk++;
+			if (index >= count){ return; }
+			Chunk& chunk = *chunks[index];
+			TraceSpan span("lex", "chunk");
+			//Positions are offsets into the whole input, so any
+			// table of it will do for reporting errors. This one
+			// is only built if the chunk has an error.
+			LineTable lines(data, size);
+			Interner::Scope interner(&chunk.interner);
+			LineTable::Scope lineScope(&lines);
+			Report::Scope report(&chunk.errors, &chunk.errors);
+			HandScanner scanner(source, chunk.begin, chunk.end, kernels);
+			scanner.tokenize(&chunk.tokens);
+		}
+	};
+
+	size_t workers = threads < count ? threads : count;
+	//What the other threads allocate is charged to this one, 
+	// whose timer covers the lex phase
+	std::vector<HeapUse> heap(workers, HeapUse{0, 0});
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < workers; i++){
+		pool.emplace_back([&heap, &work, i](){
+			work();
+			heap[i] = threadHeapUse();
+		});
+	}
+	work();
+	for (auto& worker : pool){
+		worker.join();
+	}
+	for (const HeapUse& use : heap){
+		addThreadHeapUse(use);
+	}
+
+	//Each chunk's interner numbered its identifiers in the order
+	// they appear in the chunk, so interning them chunk by chunk
+	// numbers them as lexing the whole input would have
+	Interner * interner = Interner::current();
+	size_t endLine = 1;
+	for (auto& chunk : chunks){
+		std::vector<SymbolId> ids(chunk->interner.size());
+		for (size_t i = 0; i < ids.size(); i++){
+			ids[i] = interner->intern(chunk->interner.str(
+				static_cast<SymbolId>(i)));
+		}
+		TokenStream& tokens = chunk->tokens;
+		for (size_t i = 0; i < tokens.size(); i++){
+			if (tokens.kind(i) == TokenKind::ID){
+				tokens.setValue(i, ids[tokens.value(i)]);
+			}
+		}
+		Report::errStream() << chunk->errors.str();
+		endLine += chunk->tokens.endLineNum() - 1;
+		stream->splice(&chunk->tokens);
+	}
+	stream->setEnd(endLine, chunks.back()->tokens.endColNum());
+}
+
+} //End namespace cshanty
@@ -0,0 +1,43 @@
+#ifndef CSHANTY_PARALLEL_LEXER_HPP
+#define CSHANTY_PARALLEL_LEXER_HPP
+
+#include "scan_kernels.hpp"
+#include "source_buffer.hpp"
+#include "token_stream.hpp"
+
+namespace cshanty{
+
+//Lexes a large input on several threads with HandScanner. No
+// token (not a string literal, comment or multi-word synonym)
+// runs over a newline, so the input is cut into chunks just
+// after newlines and each chunk is lexed on its own, with its
+// own interner and error stream. The chunks are then stitched
+// together in order: their identifiers are interned in the
+// current interner in the order they first appear, and their
+// errors are reported. The result is exactly what lexing the
+// whole input on one thread gives.
+class ParallelLexer{
+public:
+	//Inputs are split into at most threads chunks, but none
+	// smaller than minChunk bytes (bar the last)
+	static const size_t MIN_CHUNK = 1024 * 1024;
+
+	ParallelLexer(SourceBuffer * sourceIn, size_t threadsIn,
+		KernelSet kernelsIn = bestKernels(),
+		size_t minChunkIn = MIN_CHUNK)
+	: source(sourceIn), threads(threadsIn), kernels(kernelsIn),
+	  minChunk(minChunkIn > 0 ? minChunkIn : 1){ }
+
+	//Lex the entire input, appending every token to stream, as
+	// HandScanner::tokenize does
+	void tokenize(TokenStream * stream);
+private:
+	SourceBuffer * source;
+	size_t threads;
+	KernelSet kernels;
+	size_t minChunk;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,66 @@
+#include <algorithm>
+#include <cstring>
+#include "position.hpp"
+#include "errors.hpp"
+
+namespace cshanty{
+
+static thread_local LineTable * currentTable = nullptr;
+
+//Find each newline with memchr, which the C library implements
+// with vector instructions, rather than testing a byte at a time
+void LineTable::build(){
+	lineStarts.clear();
+	lineStarts.push_back(0);
+	const char * cur = myData;
+	const char * end = myData + mySize;
+	while (cur < end){
+		const void * found = memchr(cur, '\n', static_cast<size_t>(end - cur));
+		if (found == nullptr){ break; }
+		cur = static_cast<const char *>(found) + 1;
+		lineStarts.push_back(static_cast<uint32_t>(cur - myData));
+	}
+	built = true;
+}
+
+void LineTable::lineCol(size_t offset, size_t * line, size_t * col){
+	if (!built){ build(); }
+	auto next = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset);
+	size_t index = static_cast<size_t>(next - lineStarts.begin()) - 1;
+	*line = index + 1;
+	*col = offset - lineStarts[index] + 1;
+}
+
+size_t LineTable::lineCount(){
+	if (!built){ build(); }
+	//A newline at the very end doesn't start another line
+	size_t count = lineStarts.size();
+	if (lineStarts.back() == mySize){ count--; }
+	return count;
+}
+
+LineTable * LineTable::current(){
+	return currentTable;
+}
+
+LineTable::Scope::Scope(LineTable * table) : previous(currentTable){
+	currentTable = table;
+}
+
+LineTable::Scope::~Scope(){
+	currentTable = previous;
+}
+
+std::string Position::lineColString(uint32_t offset){
+	if (offset == NONE){ return "0,0"; }
+	LineTable * table = LineTable::current();
+	if (table == nullptr){
+		throw new InternalError("No line table for position");
+	}
+	size_t line;
+	size_t col;
+	table->lineCol(offset, &line, &col);
+	return std::to_string(line) + "," + std::to_string(col);
+}
+
+}
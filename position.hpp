@@ -1,48 +1,98 @@
 #ifndef CSHANTY_POSITION_H
 #define CSHANTY_POSITION_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace cshanty{
 
+//The start offset of every line of a source file, used to turn
+// the byte offsets stored in Positions back into line and 
+// column numbers. The table is only built the first time a 
+// line or column is actually needed (i.e. when an error is 
+// reported or tokens are written out).
+class LineTable{
+public:
+	LineTable(const char * dataIn, size_t sizeIn)
+	: myData(dataIn), mySize(sizeIn), built(false){ }
+	//A table whose line starts are already known (e.g. read
+	// back from a .csast file), for a source that isn't loaded
+	LineTable(std::vector<uint32_t>&& startsIn, size_t sizeIn)
+	: myData(nullptr), mySize(sizeIn), built(true), 
+	  lineStarts(std::move(startsIn)){ }
+
+	//The 1-based line and column of a byte offset. Columns
+	// count bytes, as the scanner does.
+	void lineCol(size_t offset, size_t * line, size_t * col);
+
+	//The number of lines in the source
+	size_t lineCount();
+
+	//The size of the source the table describes
+	size_t sourceSize() const { return mySize; }
+
+	//The start offset of each line
+	const std::vector<uint32_t>& starts(){
+		if (!built){ build(); }
+		return lineStarts;
+	}
+
+	//The line table that positions created by this thread 
+	// refer to
+	static LineTable * current();
+
+	//Makes a line table current for the calling thread for 
+	// the lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(LineTable * table);
+		~Scope();
+	private:
+		LineTable * previous;
+	};
+private:
+	void build();
+	const char * myData;
+	size_t mySize;
+	bool built;
+	std::vector<uint32_t> lineStarts;
+};
+
+//A source span, stored as a pair of byte offsets into the 
+// input (the end offset is exclusive). Line and column numbers
+// are only worked out, through the current LineTable, when the
+// position is printed.
 class Position{
 public: 
-	Position(size_t lineI, size_t colI, size_t lineE, size_t colE)
-	: myLineI(lineI), myColI(colI), myLineE(lineE), myColE(colE){
+	//The offsets of a position that refers to no source text
+	static const uint32_t NONE = UINT32_MAX;
+
+	//A position that refers to no source text
+	Position() : myStart(NONE), myEnd(NONE){ }
+	Position(size_t start, size_t end)
+	: myStart(static_cast<uint32_t>(start)), 
+	  myEnd(static_cast<uint32_t>(end)){
 	}
-	Position(Position * start, Position * end)
-	: myLineI(start->myLineI), myColI(start->myColI),
-	  myLineE(end->myLineE),myColE(end->myColE){
+	Position(const Position * start, const Position * end)
+	: myStart(start->myStart), myEnd(end->myEnd){
 	}
-	virtual void expand(Position * start, Position * end){
-	  myLineI = start->myLineI;
-	  myColI = start->myColI;
-	  myLineE = end->myLineE;
-	  myColE = end->myColE;
+	void expand(const Position * start, const Position * end){
+	  myStart = start->myStart;
+	  myEnd = end->myEnd;
 	}
-	virtual std::string begin() const{
-		std::string result = "[" 
-		+ std::to_string(myLineI)
-		+ "," 
-		+ std::to_string(myColI)
-		+ "]";
-		return result;
+	uint32_t startOffset() const { return myStart; }
+	uint32_t endOffset() const { return myEnd; }
+	std::string begin() const{
+		return "[" + lineColString(myStart) + "]";
 	}
-	virtual std::string span() const{
-		std::string result = begin()
-		+ "-[" 
-		+ std::to_string(myLineE)
-		+ "," 
-		+ std::to_string(myColE)
-		+ "]";
-		return result;
+	std::string span() const{
+		return begin() + "-[" + lineColString(myEnd) + "]";
 	}
 private:
-	size_t myLineI;
-	size_t myColI;
-	size_t myLineE;
-	size_t myColE;
-
+	static std::string lineColString(uint32_t offset);
+	uint32_t myStart;
+	uint32_t myEnd;
 };
 
 }
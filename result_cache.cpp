@@ -0,0 +1,286 @@
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include "result_cache.hpp"
+
+namespace cshanty{
+
+static const char ENTRY_MAGIC[] = "CSHC1\n";
+static const char * ENTRY_SUFFIX = ".entry";
+
+const uint64_t ResultCache::DEFAULT_LIMIT;
+const uint32_t CachedResult::TOKENS;
+const uint32_t CachedResult::UNPARSE;
+const uint32_t CachedResult::NAMES;
+
+static std::mutex cachesLock;
+static std::map<std::string, std::unique_ptr<ResultCache>> caches;
+
+//Two independent 64-bit FNV-1a hashes (with different offset
+// bases), giving a 128-bit key
+static void hashBytes(const char * data, size_t size, uint64_t * h1, uint64_t * h2){
+	const uint64_t prime = 1099511628211ULL;
+	for (size_t i = 0; i < size; i++){
+		unsigned char byte = static_cast<unsigned char>(data[i]);
+		*h1 = (*h1 ^ byte) * prime;
+		*h2 = (*h2 ^ byte) * prime;
+		*h2 ^= *h2 >> 29;
+	}
+}
+
+static const uint64_t H1_BASIS = 14695981039346656037ULL;
+static const uint64_t H2_BASIS = 0x9e3779b97f4a7c15ULL;
+
+static std::string toHex(uint64_t h1, uint64_t h2){
+	static const char digits[] = "0123456789abcdef";
+	std::string hex(32, '0');
+	for (size_t i = 0; i < 16; i++){
+		hex[15 - i] = digits[(h1 >> (4 * i)) & 0xf];
+		hex[31 - i] = digits[(h2 >> (4 * i)) & 0xf];
+	}
+	return hex;
+}
+
+//Identifies the running executable by its file's device, 
+// inode, size and modification time, so that results from any
+// other build of the compiler (even one relinked a moment ago
+// from a single changed file) are never replayed. Linking 
+// writes a new file, which changes at least the inode or the
+// time. Computed once per process; empty if the executable 
+// can't be found.
+static const std::string& compilerBuild(){
+	static const std::string build = [](){
+		struct stat exe;
+		if (stat("/proc/self/exe", &exe) != 0){ return std::string(); }
+		std::ostringstream id;
+		id << exe.st_dev << ":" << exe.st_ino << ":" << exe.st_size 
+		  << ":" << exe.st_mtim.tv_sec << "." << exe.st_mtim.tv_nsec;
+		return id.str();
+	}();
+	return build;
+}
+
+ResultCache * ResultCache::open(const std::string& dir, uint64_t limit){
+	std::lock_guard<std::mutex> guard(cachesLock);
+	//Each compilation (e.g. each request to a compile server)
+	// brings its own limit, and the latest one applies
+	auto found = caches.find(dir);
+	if (found != caches.end()){
+		ResultCache * cache = found->second.get();
+		cache->limit = limit;
+		if (cache->bytes > limit){ cache->evict(); }
+		return cache;
+	}
+
+	//Without knowing which build this is, any entry could be stale
+	if (compilerBuild().empty()){ return nullptr; }
+	if (mkdir(dir.c_str(), 0777) != 0 && errno != EEXIST){
+		return nullptr;
+	}
+	std::unique_ptr<ResultCache> cache(new ResultCache(dir, limit));
+	cache->scan();
+	ResultCache * result = cache.get();
+	caches[dir] = std::move(cache);
+	return result;
+}
+
+std::string ResultCache::key(const char * source, size_t size,
+	const std::string& phases
+){
+	uint64_t h1 = H1_BASIS;
+	uint64_t h2 = H2_BASIS;
+	std::string header = compilerBuild() + "\n" + phases + "\n";
+	hashBytes(header.data(), header.size(), &h1, &h2);
+	hashBytes(source, size, &h1, &h2);
+	return toHex(h1, h2);
+}
+
+std::string ResultCache::entryPath(const std::string& key) const{
+	return dir + "/" + key + ENTRY_SUFFIX;
+}
+
+static void writeField(std::ostream& out, const std::string& field){
+	uint64_t len = field.size();
+	out.write(reinterpret_cast<const char *>(&len), sizeof(len));
+	out.write(field.data(), static_cast<std::streamsize>(field.size()));
+}
+
+//Read a field of an entry with *left bytes still unread. A 
+// length running past the end of the entry means the entry is
+// corrupt, and is refused before anything is allocated for it.
+static bool readField(std::istream& in, std::string * field, uint64_t * left){
+	uint64_t len;
+	if (*left < sizeof(len) 
+	  || !in.read(reinterpret_cast<char *>(&len), sizeof(len))){ 
+		return false; 
+	}
+	*left -= sizeof(len);
+	if (len > *left){ return false; }
+	*left -= len;
+	field->resize(static_cast<size_t>(len));
+	if (len == 0){ return true; }
+	return static_cast<bool>(
+		in.read(&(*field)[0], static_cast<std::streamsize>(len)));
+}
+
+bool ResultCache::lookup(const std::string& key, CachedResult * result){
+	std::string path = entryPath(key);
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in.good()){
+		misses++;
+		return false;
+	}
+	std::streamoff size = in.tellg();
+	in.seekg(0);
+	char magic[sizeof(ENTRY_MAGIC) - 1];
+	const uint64_t headerSize = sizeof(magic) + sizeof(result->exitCode) 
+		+ sizeof(result->files);
+	const uint64_t entrySize = size < 0 ? 0 : static_cast<uint64_t>(size);
+	uint64_t left = entrySize;
+	bool ok = left >= headerSize
+		&& in.read(magic, sizeof(magic))
+		&& std::equal(magic, magic + sizeof(magic), ENTRY_MAGIC)
+		&& in.read(reinterpret_cast<char *>(&result->exitCode), 
+			sizeof(result->exitCode))
+		&& in.read(reinterpret_cast<char *>(&result->files), 
+			sizeof(result->files));
+	if (ok){
+		left -= headerSize;
+		ok = readField(in, &result->out, &left)
+			&& readField(in, &result->err, &left)
+			&& readField(in, &result->tokens, &left)
+			&& readField(in, &result->unparse, &left)
+			&& readField(in, &result->names, &left);
+	}
+	if (!ok){
+		//A corrupt entry is a miss, and is removed so that this
+		// compilation can store a good one in its place
+		in.close();
+		if (unlink(path.c_str()) == 0){ 
+			bytes -= std::min<uint64_t>(bytes, entrySize); 
+		}
+		misses++;
+		return false;
+	}
+	//Mark the entry as recently used, for eviction
+	utime(path.c_str(), nullptr);
+	hits++;
+	return true;
+}
+
+void ResultCache::store(const std::string& key, const CachedResult& result){
+	std::ostringstream tmpName;
+	tmpName << dir << "/" << key << ".tmp." << getpid() << "." 
+	  << std::this_thread::get_id();
+	std::string tmpPath = tmpName.str();
+	{
+		std::ofstream out(tmpPath, std::ios::binary);
+		out.write(ENTRY_MAGIC, sizeof(ENTRY_MAGIC) - 1);
+		out.write(reinterpret_cast<const char *>(&result.exitCode), 
+			sizeof(result.exitCode));
+		out.write(reinterpret_cast<const char *>(&result.files), 
+			sizeof(result.files));
+		writeField(out, result.out);
+		writeField(out, result.err);
+		writeField(out, result.tokens);
+		writeField(out, result.unparse);
+		writeField(out, result.names);
+		if (!out.good()){
+			out.close();
+			unlink(tmpPath.c_str());
+			return;
+		}
+	}
+
+	struct stat info;
+	if (stat(tmpPath.c_str(), &info) != 0 
+	  || rename(tmpPath.c_str(), entryPath(key).c_str()) != 0){
+		unlink(tmpPath.c_str());
+		return;
+	}
+	bytes += static_cast<uint64_t>(info.st_size);
+	if (bytes > limit){ evict(); }
+}
+
+//Find the entries in the directory, oldest use first
+struct CacheEntry{
+	std::string path;
+	time_t used;
+	uint64_t size;
+};
+
+static std::vector<CacheEntry> listEntries(const std::string& dir){
+	std::vector<CacheEntry> entries;
+	DIR * listing = opendir(dir.c_str());
+	if (listing == nullptr){ return entries; }
+	std::string suffix = ENTRY_SUFFIX;
+	while (dirent * file = readdir(listing)){
+		std::string name = file->d_name;
+		if (name.size() <= suffix.size()
+		  || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0){
+			continue;
+		}
+		std::string path = dir + "/" + name;
+		struct stat info;
+		if (stat(path.c_str(), &info) != 0){ continue; }
+		entries.push_back(CacheEntry{path, info.st_mtime, 
+			static_cast<uint64_t>(info.st_size)});
+	}
+	closedir(listing);
+	std::sort(entries.begin(), entries.end(), 
+		[](const CacheEntry& a, const CacheEntry& b){
+			return a.used < b.used;
+		});
+	return entries;
+}
+
+void ResultCache::scan(){
+	uint64_t total = 0;
+	for (auto& entry : listEntries(dir)){ total += entry.size; }
+	bytes = total;
+}
+
+//Remove the least recently used entries until the cache is 
+// back under 90% of its limit, so that eviction doesn't run 
+// again on the very next store. Other processes may be 
+// storing into the same directory, so start from what is 
+// actually there.
+void ResultCache::evict(){
+	std::lock_guard<std::mutex> guard(evictLock);
+	std::vector<CacheEntry> entries = listEntries(dir);
+	uint64_t total = 0;
+	for (auto& entry : entries){ total += entry.size; }
+	uint64_t target = limit / 10 * 9;
+	for (auto& entry : entries){
+		if (total <= target){ break; }
+		if (unlink(entry.path.c_str()) == 0){
+			total -= entry.size;
+			evictions++;
+		}
+	}
+	bytes = total;
+}
+
+void ResultCache::report(std::ostream& out) const{
+	out << "cache " << dir << ": " << hits << " hits, " 
+	  << misses << " misses, " << evictions << " evictions, "
+	  << bytes << " bytes stored" << std::endl;
+}
+
+void ResultCache::reportAll(std::ostream& out){
+	std::lock_guard<std::mutex> guard(cachesLock);
+	for (auto& cache : caches){
+		cache.second->report(out);
+	}
+}
+
+} //End namespace cshanty
@@ -0,0 +1,80 @@
+#ifndef CSHANTY_RESULT_CACHE_HPP
+#define CSHANTY_RESULT_CACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+namespace cshanty{
+
+//Everything a compilation of one input produced: its exit
+// code, what it wrote to the output and diagnostic streams, 
+// and the contents of the -t, -u and -n output files
+struct CachedResult{
+	static const uint32_t TOKENS = 1;
+	static const uint32_t UNPARSE = 2;
+	static const uint32_t NAMES = 4;
+
+	int32_t exitCode;
+	//Which of the output files were written
+	uint32_t files;
+	std::string out;
+	std::string err;
+	std::string tokens;
+	std::string unparse;
+	std::string names;
+};
+
+//An on-disk cache of compilation results, addressed by a hash
+// of the input's contents, the compiler build and the requested
+// phases, so that recompiling an unchanged file just replays 
+// what it produced the first time. Entries are written to a 
+// temporary file and renamed into place, so processes sharing
+// a cache directory never see a partial entry. When the entries
+// outgrow the size limit, the least recently used are removed.
+class ResultCache{
+public:
+	static const uint64_t DEFAULT_LIMIT = 256ULL * 1024 * 1024;
+
+	//The cache for a directory, shared by every compilation in
+	// the process. Opening it again sets its size limit to the
+	// new one. Returns nullptr if the directory can't be
+	// created, or if the compiler's own executable can't be found
+	// to tell which build it is.
+	static ResultCache * open(const std::string& dir, uint64_t limit);
+
+	//The key for compiling the given source with the given 
+	// phases (a string naming the requested phases)
+	static std::string key(const char * source, size_t size,
+		const std::string& phases);
+
+	bool lookup(const std::string& key, CachedResult * result);
+	void store(const std::string& key, const CachedResult& result);
+
+	//Write the hits, misses and evictions of this process
+	void report(std::ostream& out) const;
+	//Report on every cache opened by this process
+	static void reportAll(std::ostream& out);
+private:
+	ResultCache(const std::string& dirIn, uint64_t limitIn)
+	: dir(dirIn), limit(limitIn), bytes(0), 
+	  hits(0), misses(0), evictions(0){ }
+	std::string entryPath(const std::string& key) const;
+	void scan();
+	void evict();
+
+	std::string dir;
+	std::atomic<uint64_t> limit;
+	//Bytes in the cache directory, as far as this process knows
+	std::atomic<uint64_t> bytes;
+	std::atomic<size_t> hits;
+	std::atomic<size_t> misses;
+	std::atomic<size_t> evictions;
+	std::mutex evictLock;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,277 @@
+#include <cstdint>
+#include "scan_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CSHANTY_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace cshanty{
+
+static bool continuesIdent(char c){
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+		|| (c >= '0' && c <= '9') || c == '_';
+}
+
+//The scalar kernels, which also finish off whatever the vector
+// kernels leave (the last few bytes of the input)
+static size_t scalarSkipSpace(const char * data, size_t pos,
+	size_t size, size_t * lines, size_t * lineStart
+){
+	while (pos < size){
+		char c = data[pos];
+		if (c == '\n'){
+			(*lines)++;
+			*lineStart = pos + 1;
+		} else if (c != ' ' && c != '\t'){
+			break;
+		}
+		pos++;
+	}
+	return pos;
+}
+
+static size_t scalarIdentEnd(const char * data, size_t pos, size_t size){
+	while (pos < size && continuesIdent(data[pos])){ pos++; }
+	return pos;
+}
+
+static size_t scalarLineEnd(const char * data, size_t pos, size_t size){
+	while (pos < size && data[pos] != '\n'){ pos++; }
+	return pos;
+}
+
+#ifdef CSHANTY_X86_KERNELS
+
+//Each vector kernel stops either at the byte that ends the run
+// or when fewer bytes than a vector are left, and returns the
+// offset it got to. In a mask of the bytes of a vector, bit i
+// is byte i.
+
+//Where n (the bits set in a mask of the bytes of a vector)
+// includes newlines, account for those before stop
+static void countLines(uint32_t newlines, size_t pos,
+	size_t * lines, size_t * lineStart
+){
+	if (newlines == 0){ return; }
+	*lines += static_cast<size_t>(__builtin_popcount(newlines));
+	size_t last = static_cast<size_t>(31 - __builtin_clz(newlines));
+	*lineStart = pos + last + 1;
+}
+
+//Bytes from lo to hi (as unsigned values), found by moving the
+// range to start at -128 so that a signed compare can find
+// the bytes below its end
+__attribute__((target("sse2")))
+static __m128i inRange128(__m128i bytes, char lo, char hi){
+	__m128i shifted = _mm_add_epi8(bytes,
+		_mm_set1_epi8(static_cast<char>(-128 - lo)));
+	return _mm_cmplt_epi8(shifted,
+		_mm_set1_epi8(static_cast<char>(-128 + (hi - lo) + 1)));
+}
+
+__attribute__((target("sse2")))
+static size_t sse2SkipSpace(const char * data, size_t pos, size_t size,
+	size_t * lines, size_t * lineStart
+){
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (pos + 16 <= size){
+		__m128i bytes = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(data + pos));
+		__m128i isNewline = _mm_cmpeq_epi8(bytes, newline);
+		__m128i isSpace = _mm_or_si128(isNewline, _mm_or_si128(
+			_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab)));
+		uint32_t stops = ~static_cast<uint32_t>(
+			_mm_movemask_epi8(isSpace)) & 0xFFFF;
+		uint32_t newlines = static_cast<uint32_t>(
+			_mm_movemask_epi8(isNewline));
+		if (stops != 0){
+			uint32_t stop = static_cast<uint32_t>(__builtin_ctz(stops));
+			countLines(newlines & ((1u << stop) - 1), pos, lines, lineStart);
+			return pos + stop;
+		}
+		countLines(newlines, pos, lines, lineStart);
+		pos += 16;
+	}
+	return pos;
+}
+
+__attribute__((target("sse2")))
+static size_t sse2IdentEnd(const char * data, size_t pos, size_t size){
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	const __m128i underscore = _mm_set1_epi8('_');
+	while (pos + 16 <= size){
+		__m128i bytes = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(data + pos));
+		__m128i letter = inRange128(_mm_or_si128(bytes, caseBit), 'a', 'z');
+		__m128i digit = inRange128(bytes, '0', '9');
+		__m128i ident = _mm_or_si128(_mm_or_si128(letter, digit),
+			_mm_cmpeq_epi8(bytes, underscore));
+		uint32_t stops = ~static_cast<uint32_t>(
+			_mm_movemask_epi8(ident)) & 0xFFFF;
+		if (stops != 0){
+			return pos + static_cast<size_t>(__builtin_ctz(stops));
+		}
+		pos += 16;
+	}
+	return pos;
+}
+
+__attribute__((target("sse2")))
+static size_t sse2LineEnd(const char * data, size_t pos, size_t size){
+	const __m128i newline = _mm_set1_epi8('\n');
+	while (pos + 16 <= size){
+		__m128i bytes = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(data + pos));
+		uint32_t stops = static_cast<uint32_t>(
+			_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline)));
+		if (stops != 0){
+			return pos + static_cast<size_t>(__builtin_ctz(stops));
+		}
+		pos += 16;
+	}
+	return pos;
+}
+
+__attribute__((target("avx2")))
+static __m256i inRange256(__m256i bytes, char lo, char hi){
+	__m256i shifted = _mm256_add_epi8(bytes,
+		_mm256_set1_epi8(static_cast<char>(-128 - lo)));
+	//There is no 8-bit less-than, so swap the operands of >
+	return _mm256_cmpgt_epi8(
+		_mm256_set1_epi8(static_cast<char>(-128 + (hi - lo) + 1)), shifted);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2SkipSpace(const char * data, size_t pos, size_t size,
+	size_t * lines, size_t * lineStart
+){
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i tab = _mm256_set1_epi8('\t');
+	const __m256i newline = _mm256_set1_epi8('\n');
+	while (pos + 32 <= size){
+		__m256i bytes = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(data + pos));
+		__m256i isNewline = _mm256_cmpeq_epi8(bytes, newline);
+		__m256i isSpace = _mm256_or_si256(isNewline, _mm256_or_si256(
+			_mm256_cmpeq_epi8(bytes, space),
+			_mm256_cmpeq_epi8(bytes, tab)));
+		uint32_t stops = ~static_cast<uint32_t>(
+			_mm256_movemask_epi8(isSpace));
+		uint32_t newlines = static_cast<uint32_t>(
+			_mm256_movemask_epi8(isNewline));
+		if (stops != 0){
+			uint32_t stop = static_cast<uint32_t>(__builtin_ctz(stops));
+			uint32_t before = stop == 31 ? 0x7FFFFFFFu : (1u << stop) - 1;
+			countLines(newlines & before, pos, lines, lineStart);
+			return pos + stop;
+		}
+		countLines(newlines, pos, lines, lineStart);
+		pos += 32;
+	}
+	return sse2SkipSpace(data, pos, size, lines, lineStart);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2IdentEnd(const char * data, size_t pos, size_t size){
+	const __m256i caseBit = _mm256_set1_epi8(0x20);
+	const __m256i underscore = _mm256_set1_epi8('_');
+	while (pos + 32 <= size){
+		__m256i bytes = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(data + pos));
+		__m256i letter = inRange256(
+			_mm256_or_si256(bytes, caseBit), 'a', 'z');
+		__m256i digit = inRange256(bytes, '0', '9');
+		__m256i ident = _mm256_or_si256(_mm256_or_si256(letter, digit),
+			_mm256_cmpeq_epi8(bytes, underscore));
+		uint32_t stops = ~static_cast<uint32_t>(
+			_mm256_movemask_epi8(ident));
+		if (stops != 0){
+			return pos + static_cast<size_t>(__builtin_ctz(stops));
+		}
+		pos += 32;
+	}
+	return sse2IdentEnd(data, pos, size);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2LineEnd(const char * data, size_t pos, size_t size){
+	const __m256i newline = _mm256_set1_epi8('\n');
+	while (pos + 32 <= size){
+		__m256i bytes = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(data + pos));
+		uint32_t stops = static_cast<uint32_t>(
+			_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newline)));
+		if (stops != 0){
+			return pos + static_cast<size_t>(__builtin_ctz(stops));
+		}
+		pos += 32;
+	}
+	return sse2LineEnd(data, pos, size);
+}
+
+#endif
+
+KernelSet bestKernels(){
+#ifdef CSHANTY_X86_KERNELS
+	static const KernelSet best =
+		__builtin_cpu_supports("avx2") ? AVX2_KERNELS
+		: __builtin_cpu_supports("sse2") ? SSE2_KERNELS
+		: SCALAR_KERNELS;
+	return best;
+#else
+	return SCALAR_KERNELS;
+#endif
+}
+
+const char * kernelSetName(KernelSet kernels){
+	switch (kernels){
+		case SCALAR_KERNELS: return "scalar";
+		case SSE2_KERNELS: return "sse2";
+		case AVX2_KERNELS: return "avx2";
+	}
+	return "unknown";
+}
+
+size_t skipSpace(KernelSet kernels, const char * data, size_t pos,
+	size_t size, size_t * lines, size_t * lineStart
+){
+#ifdef CSHANTY_X86_KERNELS
+	if (kernels == AVX2_KERNELS){
+		pos = avx2SkipSpace(data, pos, size, lines, lineStart);
+	} else if (kernels == SSE2_KERNELS){
+		pos = sse2SkipSpace(data, pos, size, lines, lineStart);
+	}
+#endif
+	return scalarSkipSpace(data, pos, size, lines, lineStart);
+}
+
+size_t identEnd(KernelSet kernels, const char * data, size_t pos,
+	size_t size
+){
+#ifdef CSHANTY_X86_KERNELS
+	if (kernels == AVX2_KERNELS){
+		pos = avx2IdentEnd(data, pos, size);
+	} else if (kernels == SSE2_KERNELS){
+		pos = sse2IdentEnd(data, pos, size);
+	}
+#endif
+	return scalarIdentEnd(data, pos, size);
+}
+
+size_t lineEnd(KernelSet kernels, const char * data, size_t pos,
+	size_t size
+){
+#ifdef CSHANTY_X86_KERNELS
+	if (kernels == AVX2_KERNELS){
+		pos = avx2LineEnd(data, pos, size);
+	} else if (kernels == SSE2_KERNELS){
+		pos = sse2LineEnd(data, pos, size);
+	}
+#endif
+	return scalarLineEnd(data, pos, size);
+}
+
+} //End namespace cshanty
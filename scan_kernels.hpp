@@ -0,0 +1,39 @@
+#ifndef CSHANTY_SCAN_KERNELS_HPP
+#define CSHANTY_SCAN_KERNELS_HPP
+
+#include <cstddef>
+
+namespace cshanty{
+
+//Loops that find the end of a run of bytes of one class for
+// the hand-written scanner, testing 16 (SSE2) or 32 (AVX2)
+// bytes at a time where the CPU can. Every set gives exactly
+// the same results; SCALAR_KERNELS tests a byte at a time.
+// The flex scanner matches with its own tables and doesn't 
+// use them.
+enum KernelSet { SCALAR_KERNELS, SSE2_KERNELS, AVX2_KERNELS };
+
+//The fastest set this CPU supports, worked out once
+KernelSet bestKernels();
+const char * kernelSetName(KernelSet kernels);
+
+//The offset of the first byte at or after pos (or size) that
+// isn't a space, tab or \n. The number of \n skipped is added
+// to lines and, if there were any, the offset just past the
+// last one is stored in lineStart.
+size_t skipSpace(KernelSet kernels, const char * data, size_t pos,
+	size_t size, size_t * lines, size_t * lineStart);
+
+//The offset of the first byte at or after pos (or size) that
+// can't continue an identifier (a letter, digit or _)
+size_t identEnd(KernelSet kernels, const char * data, size_t pos,
+	size_t size);
+
+//The offset of the first \n at or after pos (or size), which
+// is where a comment ends
+size_t lineEnd(KernelSet kernels, const char * data, size_t pos,
+	size_t size);
+
+} //End namespace cshanty
+
+#endif
@@ -1,25 +1,21 @@
-#include <fstream>
+#include <algorithm>
+#include <cstring>
 #include "scanner.hpp"
+#include "token_stream.hpp"
 
 using namespace cshanty;
 
 using TokenKind = cshanty::Parser::token;
-using Lexeme = cshanty::Parser::semantic_type;
 
-void Scanner::outputTokens(std::ostream& outstream){
-	Lexeme lex;
-	int tokenKind;
-	while(true){
-		tokenKind = this->yylex(&lex);
-		if (tokenKind == TokenKind::END){
-			outstream << "EOF" 
-			  << " [" << this->lineNum 
-			  << "," << this->colNum << "]"
-			  << std::endl;
-			return;
-		} else {
-			outstream << lex.lexeme->toString()
-			  << std::endl;
-		}
-	}
+void Scanner::tokenize(TokenStream * stream){
+	while (this->yylex(stream) != TokenKind::END){ }
+	finish(stream);
+}
+
+int Scanner::LexerInput(char * buf, int max_size){
+	size_t remaining = mySource->size() - readPos;
+	size_t count = std::min(remaining, static_cast<size_t>(max_size));
+	memcpy(buf, mySource->data() + readPos, count);
+	readPos += count;
+	return static_cast<int>(count);
 }
@@ -6,7 +6,10 @@
 #endif
 
 #include "grammar.hh"
-#include "errors.hpp"
+#include "errScan.hpp"
+#include "interner.hpp"
+#include "source_buffer.hpp"
+#include "token_stream.hpp"
 
 using TokenKind = cshanty::Parser::token;
 
@@ -15,7 +18,10 @@ namespace cshanty{
 class Scanner : public yyFlexLexer{
 public:
    
-   Scanner(std::istream *in) : yyFlexLexer(in)
+   //The scanner reads directly from the (usually mmapped) 
+   // source buffer, so flex is given no istream
+   Scanner(SourceBuffer * sourceIn) : yyFlexLexer(nullptr),
+     mySource(sourceIn), readPos(0), tokStart(0), byteOffset(0)
    {
 	lineNum = 1;
 	colNum = 1;
@@ -26,42 +32,49 @@ public:
    //get rid of override virtual function warning
    using FlexLexer::yylex;
 
-   // YY_DECL defined in the flex cshanty.l
-   virtual int yylex( cshanty::Parser::semantic_type * const lval);
+   // YY_DECL defined in the flex cshanty.l. Each token
+   // lexed is appended to stream.
+   virtual int yylex( cshanty::TokenStream * const stream);
 
-   int makeBareToken(int tagIn){
+   int makeToken(int tagIn, uint32_t value = 0){
 	size_t len = static_cast<size_t>(yyleng);
-	Position * pos = new Position(
-	  this->lineNum, this->colNum,
-	  this->lineNum, this->colNum+len);
-        this->yylval->lexeme = new Token(pos, tagIn);
+        this->myStream->append(tagIn, tokStart, byteOffset, value);
         colNum += len;
         return tagIn;
    }
 
+   int makeBareToken(int tagIn){
+	return makeToken(tagIn);
+   }
+
+   //The span of the current match
+   Position matchPos() const {
+	return Position(tokStart, byteOffset);
+   }
+
+   //The interned identifier of the current match
+   SymbolId internLexeme() const {
+	return Interner::current()->intern(yytext, static_cast<size_t>(yyleng));
+   }
+
    void errIllegal(Position * pos, std::string match){
-	cshanty::Report::fatal(pos, "Illegal character "
-		+ match);
+	ScanErr::illegal(pos, match);
    }
 
    void errStrEsc(Position * pos){
-	cshanty::Report::fatal(pos, "String literal with bad"
-	" escape sequence ignored");
+	ScanErr::strEsc(pos);
    }
 
    void errStrUnterm(Position * pos){
-	cshanty::Report::fatal(pos, "Unterminated string"
-	" literal ignored");
+	ScanErr::strUnterm(pos);
    }
 
    void errStrEscAndUnterm(Position * pos){
-	cshanty::Report::fatal(pos, "Unterminated string literal"
-	" with bad escape sequence ignored");
+	ScanErr::strEscAndUnterm(pos);
    }
 
    void errIntOverflow(Position * pos){
-	cshanty::Report::fatal(pos, "Integer literal too large;"
-	" using max value");
+	ScanErr::intOverflow(pos);
    }
 
 /*
@@ -78,10 +91,24 @@ public:
 
    static std::string tokenKindString(int tokenKind);
 
-   void outputTokens(std::ostream& outstream);
+   //Lex the entire input, appending every token to stream
+   void tokenize(TokenStream * stream);
+   //Once yylex has returned END, record the end of the input
+   // in stream
+   void finish(TokenStream * stream){
+	stream->setEnd(lineNum, colNum);
+   }
+
+protected:
+   //Feed flex straight from the source buffer
+   virtual int LexerInput(char * buf, int max_size) override;
 
 private:
-   cshanty::Parser::semantic_type *yylval = nullptr;
+   cshanty::TokenStream * myStream = nullptr;
+   SourceBuffer * mySource;
+   size_t readPos;    //How much of mySource flex has been given
+   size_t tokStart;   //Byte offset of the current match
+   size_t byteOffset; //Byte offset just past the current match
    size_t lineNum;
    size_t colNum;
 };
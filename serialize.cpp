@@ -0,0 +1,216 @@
+#include "ast.hpp"
+#include "ast_file.hpp"
+
+namespace cshanty{
+
+//Children are always serialized before their parent, so that
+// the reader can build each node from ones it already has
+
+uint32_t ProgramNode::serialize(AstWriter * out){
+	return out->node(AstKind::PROGRAM, this, out->list(myGlobals));
+}
+
+uint32_t VarDeclNode::serialize(AstWriter * out){
+	uint32_t type = myType->serialize(out);
+	uint32_t id = myID->serialize(out);
+	return out->node(AstKind::VAR_DECL, this, type, id);
+}
+
+uint32_t FormalDeclNode::serialize(AstWriter * out){
+	uint32_t type = getTypeNode()->serialize(out);
+	uint32_t id = ID()->serialize(out);
+	return out->node(AstKind::FORMAL_DECL, this, type, id);
+}
+
+uint32_t RecordTypeDeclNode::serialize(AstWriter * out){
+	uint32_t id = myID->serialize(out);
+	uint32_t fields = out->list(myFields);
+	return out->node(AstKind::RECORD_DECL, this, id, fields);
+}
+
+uint32_t FnDeclNode::serialize(AstWriter * out){
+	uint32_t ret = myRetType->serialize(out);
+	uint32_t id = myID->serialize(out);
+	uint32_t formals = out->list(myFormals);
+	uint32_t body = out->list(myBody);
+	return out->node(AstKind::FN_DECL, this, ret, id, formals, body);
+}
+
+uint32_t AssignStmtNode::serialize(AstWriter * out){
+	return out->node(AstKind::ASSIGN_STMT, this, myExp->serialize(out));
+}
+
+uint32_t ReceiveStmtNode::serialize(AstWriter * out){
+	return out->node(AstKind::RECEIVE_STMT, this, myDst->serialize(out));
+}
+
+uint32_t ReportStmtNode::serialize(AstWriter * out){
+	return out->node(AstKind::REPORT_STMT, this, mySrc->serialize(out));
+}
+
+uint32_t PostDecStmtNode::serialize(AstWriter * out){
+	return out->node(AstKind::POST_DEC_STMT, this, 
+		myLVal->serialize(out));
+}
+
+uint32_t PostIncStmtNode::serialize(AstWriter * out){
+	return out->node(AstKind::POST_INC_STMT, this, 
+		myLVal->serialize(out));
+}
+
+uint32_t IfStmtNode::serialize(AstWriter * out){
+	uint32_t cond = myCond->serialize(out);
+	uint32_t body = out->list(myBody);
+	return out->node(AstKind::IF_STMT, this, cond, body);
+}
+
+uint32_t IfElseStmtNode::serialize(AstWriter * out){
+	uint32_t cond = myCond->serialize(out);
+	uint32_t bodyTrue = out->list(myBodyTrue);
+	uint32_t bodyFalse = out->list(myBodyFalse);
+	return out->node(AstKind::IF_ELSE_STMT, this, 
+		cond, bodyTrue, bodyFalse);
+}
+
+uint32_t WhileStmtNode::serialize(AstWriter * out){
+	uint32_t cond = myCond->serialize(out);
+	uint32_t body = out->list(myBody);
+	return out->node(AstKind::WHILE_STMT, this, cond, body);
+}
+
+uint32_t ReturnStmtNode::serialize(AstWriter * out){
+	if (myExp == nullptr){ // May happen in void functions
+		return out->node(AstKind::RETURN_STMT, this);
+	}
+	return out->node(AstKind::RETURN_STMT, this, myExp->serialize(out));
+}
+
+uint32_t CallStmtNode::serialize(AstWriter * out){
+	return out->node(AstKind::CALL_STMT, this, 
+		myCallExp->serialize(out));
+}
+
+uint32_t IDNode::serialize(AstWriter * out){
+	uint32_t str = out->string(getName());
+	return out->node(AstKind::ID, this, str, 
+		myCoord.depth, myCoord.slot);
+}
+
+uint32_t IndexNode::serialize(AstWriter * out){
+	uint32_t base = myBase->serialize(out);
+	uint32_t idx = myIdx->serialize(out);
+	return out->node(AstKind::INDEX, this, base, idx);
+}
+
+uint32_t CallExpNode::serialize(AstWriter * out){
+	uint32_t id = myID->serialize(out);
+	uint32_t args = out->list(myArgs);
+	return out->node(AstKind::CALL_EXP, this, id, args);
+}
+
+uint32_t BinaryExpNode::serializeAs(AstWriter * out, AstKind kind){
+	uint32_t lhs = myExp1->serialize(out);
+	uint32_t rhs = myExp2->serialize(out);
+	return out->node(kind, this, lhs, rhs);
+}
+
+uint32_t PlusNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::PLUS);
+}
+
+uint32_t MinusNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::MINUS);
+}
+
+uint32_t TimesNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::TIMES);
+}
+
+uint32_t DivideNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::DIVIDE);
+}
+
+uint32_t AndNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::AND);
+}
+
+uint32_t OrNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::OR);
+}
+
+uint32_t EqualsNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::EQUALS);
+}
+
+uint32_t NotEqualsNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::NOT_EQUALS);
+}
+
+uint32_t LessNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::LESS);
+}
+
+uint32_t LessEqNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::LESS_EQ);
+}
+
+uint32_t GreaterNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::GREATER);
+}
+
+uint32_t GreaterEqNode::serialize(AstWriter * out){
+	return serializeAs(out, AstKind::GREATER_EQ);
+}
+
+uint32_t NegNode::serialize(AstWriter * out){
+	return out->node(AstKind::NEG, this, myExp->serialize(out));
+}
+
+uint32_t NotNode::serialize(AstWriter * out){
+	return out->node(AstKind::NOT, this, myExp->serialize(out));
+}
+
+uint32_t AssignExpNode::serialize(AstWriter * out){
+	uint32_t dst = myDst->serialize(out);
+	uint32_t src = mySrc->serialize(out);
+	return out->node(AstKind::ASSIGN_EXP, this, dst, src);
+}
+
+uint32_t IntLitNode::serialize(AstWriter * out){
+	return out->node(AstKind::INT_LIT, this, 
+		static_cast<uint32_t>(myNum));
+}
+
+uint32_t StrLitNode::serialize(AstWriter * out){
+	return out->node(AstKind::STR_LIT, this, out->string(myStr.str()));
+}
+
+uint32_t TrueNode::serialize(AstWriter * out){
+	return out->node(AstKind::TRUE_LIT, this);
+}
+
+uint32_t FalseNode::serialize(AstWriter * out){
+	return out->node(AstKind::FALSE_LIT, this);
+}
+
+uint32_t VoidTypeNode::serialize(AstWriter * out){
+	return out->node(AstKind::VOID_TYPE, this);
+}
+
+uint32_t IntTypeNode::serialize(AstWriter * out){
+	return out->node(AstKind::INT_TYPE, this);
+}
+
+uint32_t BoolTypeNode::serialize(AstWriter * out){
+	return out->node(AstKind::BOOL_TYPE, this);
+}
+
+uint32_t StringTypeNode::serialize(AstWriter * out){
+	return out->node(AstKind::STRING_TYPE, this);
+}
+
+uint32_t RecordTypeNode::serialize(AstWriter * out){
+	return out->node(AstKind::RECORD_TYPE, this, myID->serialize(out));
+}
+
+} //End namespace cshanty
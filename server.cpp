@@ -0,0 +1,460 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <streambuf>
+#include <thread>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "batch.hpp"
+#include "driver.hpp"
+#include "errors.hpp"
+#include "result_cache.hpp"
+#include "server.hpp"
+
+//The wire format is private to cshantyc (both ends are always
+// the same binary on the same machine), so integers are sent in
+// native byte order. A request is
+//   u32 argument count, then each argument as u32 length + bytes
+//   u8 has source, then (if set) u64 length + the source bytes
+// and the reply is a sequence of frames
+//   u8 tag, u32 length, payload
+// with tag OUT_FRAME or ERR_FRAME for output, ending with an
+// EXIT_FRAME whose payload is the i32 exit code.
+
+namespace cshanty{
+
+static const char OUT_FRAME = 'o';
+static const char ERR_FRAME = 'e';
+static const char EXIT_FRAME = 'x';
+static const char * STOP_ARG = "--stop";
+//Every length in a request comes from the client, and is 
+// checked against these before the server allocates for it
+static const uint32_t MAX_ARG_BYTES = 64 * 1024;
+static const uint64_t MAX_SOURCE_BYTES = SourceBuffer::MAX_LEXABLE;
+static const size_t SOURCE_CHUNK = 1024 * 1024;
+//A client that sends nothing (or reads nothing) for this long 
+// has its request dropped, so it can't hold a thread forever
+static const time_t STALL_SECONDS = 10;
+//Connections served at once; more wait to be accepted
+static const size_t MAX_HANDLERS = 64;
+//How long a stopping server waits for requests that are still
+// compiling before it exits without them
+static const std::chrono::seconds SHUTDOWN_WAIT(30);
+
+static volatile std::sig_atomic_t signalled = 0;
+
+static void onSignal(int){
+	signalled = 1;
+}
+
+static bool writeAll(int fd, const void * data, size_t len){
+	const char * cur = static_cast<const char *>(data);
+	while (len > 0){
+		ssize_t sent = send(fd, cur, len, MSG_NOSIGNAL);
+		if (sent < 0){
+			if (errno == EINTR){ continue; }
+			return false;
+		}
+		cur += sent;
+		len -= static_cast<size_t>(sent);
+	}
+	return true;
+}
+
+static bool readAll(int fd, void * data, size_t len){
+	char * cur = static_cast<char *>(data);
+	while (len > 0){
+		ssize_t got = read(fd, cur, len);
+		if (got < 0 && errno == EINTR){ continue; }
+		if (got <= 0){ return false; }
+		cur += got;
+		len -= static_cast<size_t>(got);
+	}
+	return true;
+}
+
+static bool writeString(int fd, const std::string& str){
+	uint32_t len = static_cast<uint32_t>(str.size());
+	return writeAll(fd, &len, sizeof(len)) 
+		&& writeAll(fd, str.data(), str.size());
+}
+
+//Reads a u32 length and then that many bytes. A length over
+// maxLen is refused (setting tooLarge) before anything is 
+// allocated for it.
+static bool readString(int fd, std::string * str, 
+	uint32_t maxLen = UINT32_MAX, bool * tooLarge = nullptr
+){
+	uint32_t len;
+	if (!readAll(fd, &len, sizeof(len))){ return false; }
+	if (len > maxLen){
+		if (tooLarge != nullptr){ *tooLarge = true; }
+		return false;
+	}
+	str->resize(len);
+	return len == 0 || readAll(fd, &(*str)[0], len);
+}
+
+static bool writeFrame(int fd, char tag, const char * data, size_t len){
+	uint32_t len32 = static_cast<uint32_t>(len);
+	return writeAll(fd, &tag, 1) 
+		&& writeAll(fd, &len32, sizeof(len32))
+		&& writeAll(fd, data, len);
+}
+
+//Sends whatever is written to it over the socket as frames 
+// with the given tag, whenever its buffer fills or it is 
+// flushed (as std::endl does), so the client sees diagnostics
+// as they are reported
+class FrameBuf : public std::streambuf{
+public:
+	FrameBuf(int fdIn, char tagIn) : fd(fdIn), tag(tagIn){
+		setp(buf, buf + sizeof(buf));
+	}
+	~FrameBuf(){ sync(); }
+protected:
+	int overflow(int c) override{
+		if (sync() != 0){ return traits_type::eof(); }
+		if (c != traits_type::eof()){
+			*pptr() = static_cast<char>(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+	int sync() override{
+		size_t len = static_cast<size_t>(pptr() - pbase());
+		if (len == 0){ return 0; }
+		setp(buf, buf + sizeof(buf));
+		return writeFrame(fd, tag, buf, len) ? 0 : -1;
+	}
+private:
+	int fd;
+	char tag;
+	char buf[4096];
+};
+
+static bool makeAddress(const std::string& path, sockaddr_un * addr){
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	if (path.size() >= sizeof(addr->sun_path)){ return false; }
+	memcpy(addr->sun_path, path.c_str(), path.size() + 1);
+	return true;
+}
+
+static int connectTo(const std::string& path){
+	sockaddr_un addr;
+	if (!makeAddress(path, &addr)){ return -1; }
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0){ return -1; }
+	if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0){
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int CompileServer::serve(){
+	sockaddr_un addr;
+	if (!makeAddress(socketPath, &addr)){
+		std::cerr << "Socket path too long " << socketPath << std::endl;
+		return 1;
+	}
+	//A socket file left behind by a server that is no longer 
+	// running is removed; a live one is left alone
+	int probe = connectTo(socketPath);
+	if (probe >= 0){
+		close(probe);
+		std::cerr << "A server is already listening on " 
+		  << socketPath << std::endl;
+		return 1;
+	}
+	unlink(socketPath.c_str());
+
+	int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenFd < 0 
+	  || bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0
+	  || listen(listenFd, 64) != 0){
+		std::cerr << "Cannot listen on " << socketPath 
+		  << ": " << strerror(errno) << std::endl;
+		if (listenFd >= 0){ close(listenFd); }
+		return 1;
+	}
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+
+	//Wake up now and then to notice a stop request or signal
+	while (!stopping && !signalled){
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			if (active >= MAX_HANDLERS){
+				idle.wait_for(guard, std::chrono::milliseconds(100));
+				continue;
+			}
+		}
+		pollfd ready{listenFd, POLLIN, 0};
+		if (poll(&ready, 1, 100) <= 0){ continue; }
+		int fd = accept(listenFd, nullptr, nullptr);
+		if (fd < 0){ continue; }
+		timeval stall{STALL_SECONDS, 0};
+		setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &stall, sizeof(stall));
+		setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &stall, sizeof(stall));
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			active++;
+			connections.insert(fd);
+		}
+		std::thread(&CompileServer::handle, this, fd).detach();
+	}
+	close(listenFd);
+	unlink(socketPath.c_str());
+
+	//Requests still being read are dropped at once. Those that 
+	// have been read in full are compiling, and are given a 
+	// while to finish.
+	std::unique_lock<std::mutex> guard(lock);
+	for (int fd : connections){ shutdown(fd, SHUT_RD); }
+	bool finished = idle.wait_for(guard, SHUTDOWN_WAIT, 
+		[this](){ return active == 0; });
+	reportLatencies();
+	if (!finished){
+		//The handlers still refer to this server, so the process
+		// can't unwind past it while they run
+		std::cerr << active << " requests abandoned" << std::endl;
+		std::quick_exit(1);
+	}
+	return 0;
+}
+
+void CompileServer::handle(int fd){
+	std::vector<std::string> args;
+	std::string source;
+	bool hasSource = false;
+
+	//Why the request was refused, if it asked for more than the
+	// server will allocate. The rest of it is left unread.
+	std::string refusal;
+
+	uint32_t argCount;
+	bool ok = readAll(fd, &argCount, sizeof(argCount));
+	for (uint32_t i = 0; ok && i < argCount; i++){
+		args.emplace_back();
+		bool tooLarge = false;
+		ok = readString(fd, &args.back(), MAX_ARG_BYTES, &tooLarge);
+		if (tooLarge){ refusal = "Argument too long"; }
+	}
+	unsigned char sourceFlag = 0;
+	ok = ok && readAll(fd, &sourceFlag, 1);
+	if (ok && sourceFlag != 0){
+		uint64_t len;
+		ok = readAll(fd, &len, sizeof(len));
+		hasSource = true;
+		if (ok && len > MAX_SOURCE_BYTES){
+			refusal = "Source too large";
+			ok = false;
+		}
+		//Grown as the source arrives, so a client can't make the
+		// server allocate much more than it actually sends
+		try {
+			while (ok && source.size() < len){
+				size_t have = source.size();
+				size_t chunk = static_cast<size_t>(
+					std::min<uint64_t>(len - have, SOURCE_CHUNK));
+				source.resize(have + chunk);
+				ok = readAll(fd, &source[have], chunk);
+			}
+		} catch (std::bad_alloc&) {
+			refusal = "Out of memory for source";
+			ok = false;
+		}
+	}
+	if (!refusal.empty()){
+		std::string msg = refusal + "\n";
+		int32_t code = 1;
+		writeFrame(fd, ERR_FRAME, msg.data(), msg.size());
+		writeFrame(fd, EXIT_FRAME, reinterpret_cast<const char *>(&code), 
+			sizeof(code));
+	}
+
+	std::chrono::steady_clock::time_point start = 
+		std::chrono::steady_clock::now();
+	int exitCode = 1;
+	bool stop = false;
+	if (ok){
+		FrameBuf outBuf(fd, OUT_FRAME);
+		FrameBuf errBuf(fd, ERR_FRAME);
+		std::ostream out(&outBuf);
+		std::ostream err(&errBuf);
+		Report::Scope report(&err, &out);
+
+		Options opts;
+		std::vector<std::string> inFiles;
+		if (args.size() == 1 && args[0] == STOP_ARG){
+			stop = true;
+			exitCode = 0;
+		} else if (!parseOptions(args, &opts, &inFiles, err)){
+			usage(err);
+		} else if (hasSource && inFiles.size() != 1){
+			err << "Source given for more than 1 input file\n";
+		} else {
+			SourceBuffer * buffer = nullptr;
+			if (hasSource){ buffer = SourceBuffer::fromString(source); }
+			exitCode = compileInputs(opts, inFiles, buffer);
+		}
+		out.flush();
+		err.flush();
+	}
+	if (ok){
+		int32_t code = exitCode;
+		writeFrame(fd, EXIT_FRAME, reinterpret_cast<const char *>(&code), 
+			sizeof(code));
+	}
+	std::chrono::duration<double, std::milli> elapsed = 
+		std::chrono::steady_clock::now() - start;
+
+	std::lock_guard<std::mutex> guard(lock);
+	connections.erase(fd);
+	close(fd);
+	if (ok && !stop){ latencies.push_back(elapsed.count()); }
+	if (stop){ stopping = true; }
+	active--;
+	idle.notify_all();
+}
+
+void CompileServer::reportLatencies(){
+	std::cerr << latencies.size() << " requests served";
+	if (latencies.empty()){ 
+		std::cerr << std::endl;
+		ResultCache::reportAll(std::cerr);
+		return; 
+	}
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [this](double p){
+		size_t rank = static_cast<size_t>(p * static_cast<double>(latencies.size()));
+		if (rank >= latencies.size()){ rank = latencies.size() - 1; }
+		return latencies[rank];
+	};
+	std::cerr << "; latency (ms)"
+	  << " p50 " << percentile(0.50)
+	  << ", p90 " << percentile(0.90)
+	  << ", p99 " << percentile(0.99)
+	  << ", max " << latencies.back()
+	  << std::endl;
+	ResultCache::reportAll(std::cerr);
+}
+
+//The long options whose value is a path
+static const char * const PATH_OPTIONS[] = {
+	"--stats-json=", "--trace=", "--cache="
+};
+
+static std::string absolutePath(const std::string& path){
+	if (path.empty() || path[0] == '/'){ return path; }
+	char * cwd = getcwd(nullptr, 0);
+	if (cwd == nullptr){ return path; }
+	std::string result = std::string(cwd) + "/" + path;
+	free(cwd);
+	return result;
+}
+
+int runClient(const char * socketPath, 
+	const std::vector<std::string>& args
+){
+	//The server runs in a directory of its own, so every path
+	// is made absolute. Flags are recognized as parseOptions 
+	// does: by their second character for short flags, by 
+	// prefix for long ones.
+	std::vector<std::string> sent;
+	std::string source;
+	bool hasSource = false;
+	for (size_t i = 0; i < args.size(); i++){
+		const std::string& arg = args[i];
+		bool isShort = arg.size() > 1 && arg[0] == '-' && arg[1] != '-';
+		bool takesPath = isShort && strchr("tuna", arg[1]) != nullptr;
+		bool takesValue = takesPath || (isShort && arg[1] == 'j');
+		const char * pathPrefix = nullptr;
+		for (const char * prefix : PATH_OPTIONS){
+			if (arg.compare(0, strlen(prefix), prefix) == 0){ 
+				pathPrefix = prefix;
+			}
+		}
+		if (takesValue && i + 1 < args.size()){
+			sent.push_back(arg);
+			i++;
+			//"--" is standard output, except for -a
+			bool isPath = takesPath && (arg[1] == 'a' || args[i] != "--");
+			sent.push_back(isPath ? absolutePath(args[i]) : args[i]);
+		} else if (pathPrefix != nullptr){
+			size_t prefixLen = strlen(pathPrefix);
+			sent.push_back(pathPrefix 
+				+ absolutePath(arg.substr(prefixLen)));
+		} else if (arg == "-"){
+			source.assign(std::istreambuf_iterator<char>(std::cin), 
+				std::istreambuf_iterator<char>());
+			hasSource = true;
+			sent.push_back(arg);
+		} else if (arg[0] == '@'){
+			std::vector<std::string> listed;
+			if (!Batch::readFileList(arg.c_str() + 1, &listed)){
+				std::cerr << "Bad file list " << arg.c_str() + 1 << std::endl;
+				return 1;
+			}
+			for (auto& path : listed){ sent.push_back(absolutePath(path)); }
+		} else if (arg[0] == '-'){
+			sent.push_back(arg);
+		} else {
+			sent.push_back(absolutePath(arg));
+		}
+	}
+
+	int fd = connectTo(socketPath);
+	if (fd < 0){
+		std::cerr << "Cannot connect to " << socketPath << std::endl;
+		return 1;
+	}
+	uint32_t argCount = static_cast<uint32_t>(sent.size());
+	bool ok = writeAll(fd, &argCount, sizeof(argCount));
+	for (auto& arg : sent){
+		ok = ok && writeString(fd, arg);
+	}
+	unsigned char sourceFlag = hasSource ? 1 : 0;
+	ok = ok && writeAll(fd, &sourceFlag, 1);
+	if (hasSource){
+		uint64_t len = source.size();
+		ok = ok && writeAll(fd, &len, sizeof(len))
+			&& writeAll(fd, source.data(), source.size());
+	}
+
+	//Even if the request couldn't be sent in full, the server 
+	// may have replied to say why it stopped reading
+	std::string payload;
+	while (true){
+		char tag;
+		if (!readAll(fd, &tag, 1) || !readString(fd, &payload)){ break; }
+		if (tag == OUT_FRAME){
+			std::cout.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+			std::cout.flush();
+		} else if (tag == ERR_FRAME){
+			std::cerr.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+		} else if (tag == EXIT_FRAME && payload.size() == sizeof(int32_t)){
+			int32_t code;
+			memcpy(&code, payload.data(), sizeof(code));
+			close(fd);
+			return code;
+		}
+	}
+	close(fd);
+	std::cerr << "Lost connection to " << socketPath << std::endl;
+	return 1;
+}
+
+} //End namespace cshanty
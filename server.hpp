@@ -0,0 +1,59 @@
+#ifndef CSHANTY_SERVER_HPP
+#define CSHANTY_SERVER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace cshanty{
+
+//A long-running compiler that takes requests over a Unix domain
+// socket, so that a build which runs the compiler many times 
+// pays for process startup (and a cold heap) only once. Each 
+// request carries the same arguments as the command line, and
+// optionally the source to compile in place of reading the 
+// input file. The output and diagnostics of the request are 
+// streamed back as they are produced, followed by its exit code.
+// Requests are served concurrently, one thread per connection,
+// up to a limit. A client that stalls has its request dropped.
+class CompileServer{
+public:
+	CompileServer(const char * socketPathIn) 
+	: socketPath(socketPathIn), stopping(false), active(0){ }
+
+	//Serve requests until a stop request (or SIGINT/SIGTERM)
+	// arrives, then report request latencies. Requests that
+	// are compiling are waited for, but only for so long; the
+	// process exits without them if they take longer. Returns
+	// the process exit code.
+	int serve();
+private:
+	void handle(int fd);
+	void reportLatencies();
+
+	std::string socketPath;
+	std::atomic<bool> stopping;
+
+	//Connections being served (and their sockets), and the 
+	// time taken by each request served so far (in milliseconds)
+	std::mutex lock;
+	std::condition_variable idle;
+	size_t active;
+	std::set<int> connections;
+	std::vector<double> latencies;
+};
+
+//Send a request to the server listening at socketPath and 
+// write out what comes back. Input and output file arguments
+// are made absolute, @fileLists are expanded, and an input of
+// '-' sends standard input as the source. Returns the exit code
+// of the request.
+int runClient(const char * socketPath, 
+	const std::vector<std::string>& args);
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,278 @@
+#include <exception>
+#include <sstream>
+#include <thread>
+#include "session.hpp"
+#include "ast_file.hpp"
+#include "errors.hpp"
+#include "hand_scanner.hpp"
+#include "parallel_lexer.hpp"
+#include "scanner.hpp"
+#include "token_pipe.hpp"
+#include "name_analysis.hpp"
+#include "type_analysis.hpp"
+
+namespace cshanty{
+
+CompilationSession::CompilationSession(const char * inPathIn,
+	SourceBuffer * source)
+: inPath(inPathIn),
+  mySource(source ? source : SourceBuffer::open(inPathIn)), 
+  myLines(nullptr), astInput(false),
+  scannerKind(FLEX_SCANNER), scanKernels(bestKernels()), lexThreads(1),
+  pipelined(false), myTokens(nullptr), parsed(false), myAST(nullptr),
+  nameAnalyzed(false), myNameAnalysis(nullptr),
+  typeAnalyzed(false), myTypeAnalysis(nullptr){
+	if (mySource == nullptr){ return; }
+	astInput = AstReader::matches(mySource->data(), mySource->size());
+	if (astInput){
+		//Left null if the file is malformed, which ast() reports
+		myLines = AstReader::lineTable(mySource);
+	} else {
+		myLines = new LineTable(mySource->data(), mySource->size());
+	}
+}
+
+CompilationSession::~CompilationSession(){
+	delete myTypeAnalysis;
+	delete myNameAnalysis;
+	delete myTokens;
+	delete myLines;
+	delete mySource;
+}
+
+void CompilationSession::checkLexable(){
+	if (mySource == nullptr){
+		std::string msg = "Bad input stream ";
+		msg += inPath;
+		throw new InternalError(msg.c_str());
+	}
+	if (astInput){
+		std::string msg = "No tokens in AST file ";
+		msg += inPath;
+		throw new InternalError(msg.c_str());
+	}
+	if (mySource->size() > SourceBuffer::MAX_LEXABLE){
+		std::string msg = "Input file too large ";
+		msg += inPath;
+		throw new InternalError(msg.c_str());
+	}
+}
+
+TokenStream * CompilationSession::tokens(){
+	if (myTokens != nullptr){ return myTokens; }
+	checkLexable();
+
+	Activation active(this);
+	TokenStream * stream;
+	{
+		CompileStats::Timer timer(&myStats, LEX_PHASE, myArena);
+		stream = new TokenStream(mySource);
+		if (scannerKind == HAND_SCANNER && lexThreads > 1){
+			ParallelLexer lexer(mySource, lexThreads, scanKernels);
+			lexer.tokenize(stream);
+		} else if (scannerKind == HAND_SCANNER){
+			HandScanner scanner(mySource, scanKernels);
+			scanner.tokenize(stream);
+		} else {
+			Scanner scanner(mySource);
+			scanner.tokenize(stream);
+		}
+	}
+	myStats.tokens = stream->size();
+
+	myTokens = stream;
+	return myTokens;
+}
+
+void CompilationSession::writeTokens(std::ostream& out){
+	TokenStream * stream = tokens();
+	Activation active(this);
+	stream->output(out);
+}
+
+ProgramNode * CompilationSession::ast(){
+	if (parsed){ return myAST; }
+	if (astInput){ return loadAST(); }
+	if (pipelined && myTokens == nullptr){ return parsePipelined(); }
+
+	TokenStream * stream = tokens();
+	stream->rewind();
+
+	Activation active(this);
+	CompileStats::Timer timer(&myStats, PARSE_PHASE, myArena);
+
+	//This pointer will be set to the root of the
+	// AST after parsing
+	ProgramNode * root = nullptr;
+	Parser parser(*stream, &root);
+	int errCode = parser.parse();
+
+	parsed = true;
+	myAST = (errCode == 0) ? root : nullptr;
+	return myAST;
+}
+
+//Lex with scanner, pushing each token into pipe as it is lexed
+template <typename Lexer>
+static void pumpTokens(Lexer * scanner, const SourceBuffer * source,
+	TokenPipe * pipe
+){
+	//The scanner appends each token to a stream, which never
+	// holds more than that one token
+	TokenStream one(source);
+	while (scanner->yylex(&one) != Parser::token::END){
+		pipe->push(one.kind(0), one.pos(0)->startOffset(),
+			one.pos(0)->endOffset(), one.value(0));
+		one.clear();
+	}
+	scanner->finish(&one);
+	pipe->close(one.endLineNum(), one.endColNum());
+}
+
+ProgramNode * CompilationSession::parsePipelined(){
+	checkLexable();
+	Activation active(this);
+
+	//Lexical errors are held back until parsing is done, and
+	// the parser's too, so that they come out in the same order
+	// as when the input is lexed before it is parsed
+	TokenPipe pipe;
+	std::ostringstream lexErrors;
+	std::exception_ptr lexFailure;
+	TraceLog * trace = TraceLog::current();
+	std::thread lexer([&](){
+		TraceLog::Scope traced(trace);
+		Interner::Scope interner(&myInterner);
+		//The parser may be using the session's line table, so
+		// errors are placed with one of the lexer's own
+		LineTable lines(mySource->data(), mySource->size());
+		LineTable::Scope lineScope(&lines);
+		Report::Scope report(&lexErrors, &lexErrors);
+		//Lexing puts nothing in the session's arena, which the
+		// parser is allocating from
+		Arena none;
+		CompileStats::Timer timer(&myStats, LEX_PHASE, none);
+		try {
+			if (scannerKind == HAND_SCANNER){
+				HandScanner scanner(mySource, scanKernels);
+				pumpTokens(&scanner, mySource, &pipe);
+			} else {
+				Scanner scanner(mySource);
+				pumpTokens(&scanner, mySource, &pipe);
+			}
+		} catch (...) {
+			lexFailure = std::current_exception();
+			pipe.close(1, 1);
+		}
+	});
+
+	TokenStream * stream = new TokenStream(mySource);
+	std::ostringstream parseErrors;
+	ProgramNode * root = nullptr;
+	int errCode = 1;
+	std::exception_ptr parseFailure;
+	{
+		CompileStats::Timer timer(&myStats, PARSE_PHASE, myArena);
+		Report::Scope report(&parseErrors, &Report::outStream());
+		stream->pullFrom(&pipe);
+		try {
+			Parser parser(*stream, &root);
+			errCode = parser.parse();
+		} catch (...) {
+			parseFailure = std::current_exception();
+		}
+		//The parser stops at a syntax error, but the token 
+		// stream should still hold every token
+		stream->drain();
+	}
+	lexer.join();
+
+	myTokens = stream;
+	myStats.tokens = stream->size();
+	myStats.pipeline = pipe.counters();
+	if (lexFailure){ std::rethrow_exception(lexFailure); }
+	Report::errStream() << lexErrors.str() << parseErrors.str();
+	if (parseFailure){ std::rethrow_exception(parseFailure); }
+
+	parsed = true;
+	myAST = (errCode == 0) ? root : nullptr;
+	return myAST;
+}
+
+ProgramNode * CompilationSession::loadAST(){
+	if (mySource == nullptr){
+		std::string msg = "Bad input stream ";
+		msg += inPath;
+		throw new InternalError(msg.c_str());
+	}
+
+	Activation active(this);
+	CompileStats::Timer timer(&myStats, PARSE_PHASE, myArena);
+	//Set first, so that a malformed file is only reported once
+	parsed = true;
+	myAST = AstReader::load(mySource);
+	return myAST;
+}
+
+void CompilationSession::writeAST(std::ostream& out){
+	ProgramNode * root = ast();
+	if (root == nullptr){
+		throw new InternalError("No AST to write");
+	}
+	Activation active(this);
+	AstWriter::write(root, out, myLines, resolved());
+}
+
+NameAnalysis * CompilationSession::nameAnalysis(){
+	if (nameAnalyzed){ return myNameAnalysis; }
+
+	ProgramNode * root = ast();
+	nameAnalyzed = true;
+	if (root == nullptr){ return nullptr; }
+
+	Activation active(this);
+	SymbolTableStats symbols;
+	{
+		CompileStats::Timer timer(&myStats, NAMES_PHASE, myArena);
+		myNameAnalysis = NameAnalysis::build(root, &symbols);
+	}
+	myStats.scopesEntered = symbols.scopesEntered;
+	myStats.lookups = symbols.lookups;
+	return myNameAnalysis;
+}
+
+TypeAnalysis * CompilationSession::typeAnalysis(){
+	if (typeAnalyzed){ return myTypeAnalysis; }
+
+	NameAnalysis * names = nameAnalysis();
+	typeAnalyzed = true;
+	if (names == nullptr){ return nullptr; }
+
+	Activation active(this);
+	CompileStats::Timer timer(&myStats, TYPES_PHASE, myArena);
+	myTypeAnalysis = TypeAnalysis::build(names, &myStats.typeEntries);
+	return myTypeAnalysis;
+}
+
+const CompileStats& CompilationSession::stats(){
+	if (myAST != nullptr && myStats.nodeKinds.empty()){
+		Activation active(this);
+		AstWriter counter;
+		myAST->serialize(&counter);
+		myStats.nodeKinds = counter.kindCounts();
+	}
+	return myStats;
+}
+
+void CompilationSession::reportMemory(std::ostream& out) const{
+	out << "arena bytes for " << inPath << ":"
+	  << " lex " << myStats.phase(LEX_PHASE).arenaBytes
+	  << ", parse " << myStats.phase(PARSE_PHASE).arenaBytes
+	  << ", names " << myStats.phase(NAMES_PHASE).arenaBytes
+	  << ", types " << myStats.phase(TYPES_PHASE).arenaBytes
+	  << " (" << myArena.allocations() << " allocations, "
+	  << myArena.bytesReserved() << " bytes reserved)"
+	  << std::endl;
+}
+
+} //End namespace cshanty
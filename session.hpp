@@ -0,0 +1,159 @@
+#ifndef CSHANTY_SESSION_HPP
+#define CSHANTY_SESSION_HPP
+
+#include <ostream>
+#include <string>
+#include "arena.hpp"
+#include "ast.hpp"
+#include "interner.hpp"
+#include "node_ids.hpp"
+#include "scan_kernels.hpp"
+#include "source_buffer.hpp"
+#include "stats.hpp"
+#include "token_stream.hpp"
+#include "type_context.hpp"
+
+namespace cshanty{
+
+class NameAnalysis;
+class TypeAnalysis;
+
+//The scanners that can lex source input: the flex scanner
+// (Scanner), and a hand-written one (HandScanner) that 
+// produces exactly the same tokens
+enum ScannerKind { FLEX_SCANNER, HAND_SCANNER };
+
+//All of the work done on a single input file. Each phase
+// is run at most once, the first time its result is asked
+// for, and its result is kept for any later phase (or output
+// flag) that needs it. Thus, running several of -t, -u, -n
+// and -c together only lexes and parses the input once.
+// Everything the phases build is placed in the session's 
+// arena and freed, all at once, along with the session, which
+// also owns the token stream and the analyses.
+class CompilationSession{
+public:
+	//Compile the file at inPath or, if source is given, that 
+	// source (which the session takes ownership of) under the
+	// name inPath
+	CompilationSession(const char * inPath, 
+		SourceBuffer * source = nullptr);
+	~CompilationSession();
+
+	//Whether the input file could be opened
+	bool good() const { return mySource != nullptr; }
+	const std::string& path() const { return inPath; }
+	const SourceBuffer * source() const { return mySource; }
+	//Whether the input file is a .csast (a saved AST) rather
+	// than source, in which case it is loaded instead of parsed
+	bool isAst() const { return astInput; }
+	//The number of lines in the input file (or in the source
+	// a .csast was built from)
+	size_t lineCount(){ return myLines ? myLines->lineCount() : 0; }
+
+	//Which scanner tokens() lexes with (FLEX_SCANNER unless 
+	// set), and for HAND_SCANNER, with which kernels. Only has
+	// an effect before the input is lexed.
+	void useScanner(ScannerKind kind, KernelSet kernels = bestKernels()){
+		scannerKind = kind;
+		scanKernels = kernels;
+	}
+	//Lex large inputs on this many threads (ParallelLexer). Only
+	// HAND_SCANNER can lex in parallel.
+	void useLexThreads(size_t threads){ lexThreads = threads; }
+	//Whether ast() lexes on a thread of its own, feeding the
+	// parser through a TokenPipe as it goes, when the input
+	// hasn't already been lexed. The scanner runs on one
+	// thread, whatever useLexThreads says.
+	void usePipeline(bool pipelineIn){ pipelined = pipelineIn; }
+
+	//The token stream of the input file. There is none for
+	// a .csast input (InternalError).
+	TokenStream * tokens();
+	//Write out the token stream (the -t flag)
+	void writeTokens(std::ostream& out);
+
+	//Write out the AST as a .csast file (the -a flag)
+	void writeAST(std::ostream& out);
+
+	//The root of the AST, or nullptr if parsing failed
+	ProgramNode * ast();
+
+	//The name analysis of the AST, or nullptr if either 
+	// parsing or name analysis failed
+	NameAnalysis * nameAnalysis();
+	//Whether name analysis has run and succeeded, so the IDs
+	// in the AST carry their coords
+	bool resolved() const { 
+		return nameAnalyzed && myNameAnalysis != nullptr; 
+	}
+
+	//The type analysis of the AST, or nullptr if any
+	// earlier phase or type analysis failed
+	TypeAnalysis * typeAnalysis();
+
+	//What each phase run so far cost, with the AST's node 
+	// counts filled in
+	const CompileStats& stats();
+	//For charging the driver's output to OUTPUT_PHASE
+	CompileStats * phaseStats(){ return &myStats; }
+	const Arena& arena() const { return myArena; }
+	void reportMemory(std::ostream& out) const;
+
+	//Makes the session's arena, interner, node IDs, type 
+	// context and line table current for the calling 
+	// thread. Each phase activates its session while it 
+	// runs; drivers that inspect the results (e.g. 
+	// unparsing the AST) should do the same.
+	class Activation{
+	public:
+		Activation(CompilationSession * session)
+		: arena(&session->myArena), 
+		  interner(&session->myInterner),
+		  nodeIds(&session->myNodeIds),
+		  types(&session->myTypes),
+		  lines(session->myLines){ }
+	private:
+		Arena::Scope arena;
+		Interner::Scope interner;
+		NodeIds::Scope nodeIds;
+		TypeContext::Scope types;
+		LineTable::Scope lines;
+	};
+private:
+	//Throw an InternalError if the input can't be lexed
+	void checkLexable();
+	ProgramNode * loadAST();
+	ProgramNode * parsePipelined();
+
+	std::string inPath;
+	Arena myArena;
+	Interner myInterner;
+	NodeIds myNodeIds;
+	TypeContext myTypes;
+	CompileStats myStats;
+	//The input file. Tokens refer into this buffer, so it 
+	// lives as long as the session does
+	SourceBuffer * mySource;
+	LineTable * myLines;
+	bool astInput;
+
+	ScannerKind scannerKind;
+	KernelSet scanKernels;
+	size_t lexThreads;
+	bool pipelined;
+	TokenStream * myTokens;
+
+	bool parsed;
+	ProgramNode * myAST;
+
+	bool nameAnalyzed;
+	NameAnalysis * myNameAnalysis;
+
+	bool typeAnalyzed;
+	TypeAnalysis * myTypeAnalysis;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -0,0 +1,63 @@
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "source_buffer.hpp"
+
+namespace cshanty{
+
+//Read the whole file into the heap, for inputs that cannot be 
+// mapped (pipes, special files, etc.)
+static SourceBuffer * readWhole(const char * path){
+	std::ifstream inStream(path, std::ios::in | std::ios::binary);
+	if (!inStream.good()){ return nullptr; }
+	std::string contents(
+		(std::istreambuf_iterator<char>(inStream)),
+		std::istreambuf_iterator<char>());
+	return SourceBuffer::fromString(contents);
+}
+
+SourceBuffer * SourceBuffer::open(const char * path){
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0){ return nullptr; }
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+		close(fd);
+		return readWhole(path);
+	}
+
+	size_t size = static_cast<size_t>(info.st_size);
+	if (size == 0){
+		close(fd);
+		return fromString("");
+	}
+
+	void * addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED){
+		return readWhole(path);
+	}
+	madvise(addr, size, MADV_SEQUENTIAL);
+	return new SourceBuffer(static_cast<const char *>(addr), size, true);
+}
+
+SourceBuffer * SourceBuffer::fromString(const std::string& text){
+	char * copy = new char[text.size() + 1];
+	memcpy(copy, text.data(), text.size());
+	copy[text.size()] = '\0';
+	return new SourceBuffer(copy, text.size(), false);
+}
+
+SourceBuffer::~SourceBuffer(){
+	if (mapped){
+		munmap(const_cast<char *>(myData), mySize);
+	} else {
+		delete [] myData;
+	}
+}
+
+} //End namespace cshanty
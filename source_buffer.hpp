@@ -0,0 +1,58 @@
+#ifndef CSHANTY_SOURCE_BUFFER_HPP
+#define CSHANTY_SOURCE_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace cshanty{
+
+//A (pointer, length) view of some bytes of a SourceBuffer.
+// Views are only valid for as long as the buffer they point
+// into, but let tokens refer to their lexeme without copying
+// it out of the input.
+class SourceView{
+public:
+	SourceView() : myData(nullptr), myLen(0){ }
+	SourceView(const char * dataIn, size_t lenIn) 
+	: myData(dataIn), myLen(lenIn){ }
+	const char * data() const { return myData; }
+	size_t length() const { return myLen; }
+	std::string str() const { return std::string(myData, myLen); }
+private:
+	const char * myData;
+	size_t myLen;
+};
+
+//The complete contents of an input file. Where possible the 
+// file is mmapped, so that it is read straight out of the page
+// cache rather than being copied through an istream. 
+class SourceBuffer{
+public:
+	//The largest input that can be lexed, since positions hold
+	// 32-bit byte offsets
+	static const uint64_t MAX_LEXABLE = UINT32_MAX - 1;
+
+	//Map the file at path, or return nullptr if it cannot 
+	// be opened
+	static SourceBuffer * open(const char * path);
+	//Wrap an in-memory copy of some source text
+	static SourceBuffer * fromString(const std::string& text);
+	~SourceBuffer();
+
+	const char * data() const { return myData; }
+	size_t size() const { return mySize; }
+	SourceView view(size_t offset, size_t len) const{
+		return SourceView(myData + offset, len);
+	}
+private:
+	SourceBuffer(const char * dataIn, size_t sizeIn, bool mappedIn)
+	: myData(dataIn), mySize(sizeIn), mapped(mappedIn){ }
+	const char * myData;
+	size_t mySize;
+	bool mapped;
+};
+
+} //End namespace cshanty
+
+#endif
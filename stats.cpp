@@ -0,0 +1,191 @@
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+#include <sys/resource.h>
+#include "ast_file.hpp"
+#include "stats.hpp"
+
+namespace cshanty{
+
+//What the calling thread has allocated on the heap, counted by
+// the operator new at the end of this file
+static thread_local HeapUse heapUse = {0, 0};
+
+HeapUse threadHeapUse(){
+	return heapUse;
+}
+
+void addThreadHeapUse(const HeapUse& use){
+	heapUse.allocations += use.allocations;
+	heapUse.bytes += use.bytes;
+}
+
+//CPU time of the calling thread, which runs every phase of a
+// compilation, so that batch workers don't see each other's
+static double threadCpuMs(){
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return static_cast<double>(now.tv_sec) * 1e3 
+		+ static_cast<double>(now.tv_nsec) / 1e6;
+}
+
+static size_t peakRssBytes(){
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0){ return 0; }
+	//Reported in kilobytes on Linux
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+CompileStats::CompileStats()
+: tokens(0), scopesEntered(0), lookups(0), typeEntries(0),
+  pipeline(PipelineStats{false, 0, 0, 0, 0, 0}){
+	for (PhaseStats& phase : phases){
+		phase = PhaseStats{false, 0, 0, 0, 0, 0, 0, 0};
+	}
+}
+
+const char * CompileStats::phaseName(Phase phase){
+	switch (phase){
+	case LEX_PHASE: return "lex";
+	case PARSE_PHASE: return "parse";
+	case NAMES_PHASE: return "names";
+	case TYPES_PHASE: return "types";
+	case OUTPUT_PHASE: return "output";
+	case PHASE_COUNT: break;
+	}
+	return "unknown";
+}
+
+CompileStats::Timer::Timer(CompileStats * stats, Phase phase, 
+	const Arena& arenaIn)
+: target(&stats->phases[phase]), arena(arenaIn),
+  wallStart(std::chrono::steady_clock::now()), 
+  cpuStart(threadCpuMs()), 
+  heapStart(threadHeapUse()),
+  arenaAllocationsStart(arenaIn.allocations()), 
+  arenaBytesStart(arenaIn.bytesUsed()), span("phase", phaseName(phase)){
+}
+
+CompileStats::Timer::~Timer(){
+	std::chrono::duration<double, std::milli> wall = 
+		std::chrono::steady_clock::now() - wallStart;
+	target->ran = true;
+	target->wallMs += wall.count();
+	target->cpuMs += threadCpuMs() - cpuStart;
+	HeapUse heap = threadHeapUse();
+	target->heapAllocations += heap.allocations - heapStart.allocations;
+	target->heapBytes += heap.bytes - heapStart.bytes;
+	target->arenaAllocations += arena.allocations() - arenaAllocationsStart;
+	target->arenaBytes += arena.bytesUsed() - arenaBytesStart;
+	target->peakRss = peakRssBytes();
+}
+
+void CompileStats::write(std::ostream& out, const std::string& path) const{
+	out << "stats for " << path << ":\n"
+	  << "  phase      wall ms     cpu ms  heap allocs   heap bytes"
+	  << "  arena allocs  arena bytes  peak RSS KB\n";
+	std::ios::fmtflags flags = out.flags();
+	out << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < PHASE_COUNT; i++){
+		const PhaseStats& p = phases[i];
+		if (!p.ran){ continue; }
+		out << "  " << std::left << std::setw(7) 
+		  << phaseName(static_cast<Phase>(i)) << std::right
+		  << std::setw(11) << p.wallMs 
+		  << std::setw(11) << p.cpuMs
+		  << std::setw(13) << p.heapAllocations
+		  << std::setw(13) << p.heapBytes
+		  << std::setw(14) << p.arenaAllocations
+		  << std::setw(13) << p.arenaBytes
+		  << std::setw(13) << p.peakRss / 1024 << "\n";
+	}
+	out.flags(flags);
+
+	size_t nodes = 0;
+	for (size_t count : nodeKinds){ nodes += count; }
+	out << "  tokens " << tokens << ", AST nodes " << nodes 
+	  << ", scopes entered " << scopesEntered
+	  << ", symbol lookups " << lookups
+	  << ", type map entries " << typeEntries << "\n";
+	if (pipeline.used){
+		out << "  pipeline: ring of " << pipeline.capacity
+		  << ", lexer stalls " << pipeline.lexerStalls
+		  << ", parser stalls " << pipeline.parserStalls
+		  << ", occupancy mean " << pipeline.meanOccupancy
+		  << " max " << pipeline.maxOccupancy << "\n";
+	}
+	if (nodes == 0){ return; }
+	out << "  nodes by kind:";
+	size_t shown = 0;
+	for (size_t i = 0; i < nodeKinds.size(); i++){
+		if (nodeKinds[i] == 0){ continue; }
+		out << (shown++ % 6 == 0 ? "\n    " : ", ")
+		  << astKindName(static_cast<AstKind>(i)) << " " << nodeKinds[i];
+	}
+	out << std::endl;
+}
+
+void CompileStats::writeJson(std::ostream& out, const std::string& path) const{
+	out << "{\"file\": ";
+	writeJsonString(out, path);
+	out << ", \"phases\": {";
+	bool first = true;
+	for (size_t i = 0; i < PHASE_COUNT; i++){
+		const PhaseStats& p = phases[i];
+		if (!p.ran){ continue; }
+		out << (first ? "" : ", ") << '"' 
+		  << phaseName(static_cast<Phase>(i)) << "\": {"
+		  << "\"wall_ms\": " << p.wallMs 
+		  << ", \"cpu_ms\": " << p.cpuMs
+		  << ", \"heap_allocations\": " << p.heapAllocations
+		  << ", \"heap_bytes\": " << p.heapBytes
+		  << ", \"arena_allocations\": " << p.arenaAllocations
+		  << ", \"arena_bytes\": " << p.arenaBytes
+		  << ", \"peak_rss_bytes\": " << p.peakRss << "}";
+		first = false;
+	}
+	out << "}, \"tokens\": " << tokens
+	  << ", \"scopes_entered\": " << scopesEntered
+	  << ", \"symbol_lookups\": " << lookups
+	  << ", \"type_map_entries\": " << typeEntries;
+	if (pipeline.used){
+		out << ", \"pipeline\": {\"capacity\": " << pipeline.capacity
+		  << ", \"lexer_stalls\": " << pipeline.lexerStalls
+		  << ", \"parser_stalls\": " << pipeline.parserStalls
+		  << ", \"mean_occupancy\": " << pipeline.meanOccupancy
+		  << ", \"max_occupancy\": " << pipeline.maxOccupancy << "}";
+	}
+	out << ", \"nodes\": {";
+	first = true;
+	for (size_t i = 0; i < nodeKinds.size(); i++){
+		if (nodeKinds[i] == 0){ continue; }
+		out << (first ? "" : ", ") << '"' 
+		  << astKindName(static_cast<AstKind>(i)) << "\": " 
+		  << nodeKinds[i];
+		first = false;
+	}
+	out << "}}";
+}
+
+} //End namespace cshanty
+
+//Count every heap allocation against the thread making it.
+// Replacing operator new replaces it for the whole program, so
+// anything linking this file (including the benchmarks) is
+// counted.
+void * operator new(size_t size){
+	cshanty::heapUse.allocations++;
+	cshanty::heapUse.bytes += size;
+	void * block = std::malloc(size == 0 ? 1 : size);
+	if (block == nullptr){ throw std::bad_alloc(); }
+	return block;
+}
+
+void operator delete(void * block) noexcept{
+	std::free(block);
+}
+
+void operator delete(void * block, size_t) noexcept{
+	std::free(block);
+}
@@ -0,0 +1,115 @@
+#ifndef CSHANTY_STATS_HPP
+#define CSHANTY_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "trace.hpp"
+
+namespace cshanty{
+
+enum Phase {
+	LEX_PHASE, PARSE_PHASE, NAMES_PHASE, TYPES_PHASE, OUTPUT_PHASE,
+	PHASE_COUNT
+};
+
+//What one phase of a compilation cost. Heap allocations are
+// the operator new calls the phase made and the bytes they 
+// asked for (not net of frees): side tables such as the token
+// arrays, symbol table, interner and node type vector. Arena 
+// allocations are the objects put in the session's arena, 
+// whose chunks come from malloc and so are not heap 
+// allocations too. With --pipeline the parser fills the token
+// arrays, so they are charged to parse rather than lex. Peak 
+// RSS is the process's high water mark when the phase 
+// finished, so in batch mode it covers every file compiled so
+// far.
+struct PhaseStats{
+	bool ran;
+	double wallMs;
+	double cpuMs;
+	size_t heapAllocations;
+	size_t heapBytes;
+	size_t arenaAllocations;
+	size_t arenaBytes;
+	size_t peakRss;
+};
+
+//The heap blocks and bytes the calling thread has allocated so
+// far, as counted by the operator new that stats.cpp defines
+struct HeapUse{
+	size_t allocations;
+	size_t bytes;
+};
+HeapUse threadHeapUse();
+//Count allocations another thread made as the calling thread's,
+// for work it handed to that thread and waited for
+void addThreadHeapUse(const HeapUse& use);
+
+//How well lexing and parsing overlapped, when the scanner fed
+// the parser through a TokenPipe (the --pipeline flag). The
+// lexer stalls when the ring is full and the parser when it is
+// empty; occupancy is the tokens waiting each time the parser
+// caught up with what it had last seen of the ring.
+struct PipelineStats{
+	bool used;
+	size_t capacity;
+	size_t lexerStalls;
+	size_t parserStalls;
+	double meanOccupancy;
+	size_t maxOccupancy;
+};
+
+//Where a compilation spent its time and memory (the --stats 
+// flag), and how much work each phase did
+class CompileStats{
+public:
+	CompileStats();
+
+	static const char * phaseName(Phase phase);
+
+	const PhaseStats& phase(Phase phase) const { 
+		return phases[phase]; 
+	}
+
+	size_t tokens;
+	//Nodes of each kind, indexed by AstKind (empty if there 
+	// is no AST)
+	std::vector<size_t> nodeKinds;
+	size_t scopesEntered;
+	size_t lookups;
+	size_t typeEntries;
+	PipelineStats pipeline;
+
+	//Write the stats as a table, or as a JSON object
+	void write(std::ostream& out, const std::string& path) const;
+	void writeJson(std::ostream& out, const std::string& path) const;
+
+	//Charges the time and allocations made during its lifetime
+	// to a phase. Heap allocations are those of the thread that
+	// made the timer. Phases run more than once (e.g. the output
+	// phase) accumulate. The phase is also traced, if tracing.
+	class Timer{
+	public:
+		Timer(CompileStats * stats, Phase phase, const Arena& arena);
+		~Timer();
+	private:
+		PhaseStats * target;
+		const Arena& arena;
+		std::chrono::steady_clock::time_point wallStart;
+		double cpuStart;
+		HeapUse heapStart;
+		size_t arenaAllocationsStart;
+		size_t arenaBytesStart;
+		TraceSpan span;
+	};
+private:
+	PhaseStats phases[PHASE_COUNT];
+};
+
+} //End namespace cshanty
+
+#endif
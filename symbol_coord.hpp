@@ -0,0 +1,34 @@
+#ifndef CSHANTY_SYMBOL_COORD_HPP
+#define CSHANTY_SYMBOL_COORD_HPP
+
+#include <cstdint>
+
+namespace cshanty{
+
+//Where a variable lives, as worked out during name analysis.
+// depth is the nesting depth of the scope that declared the 
+// variable (GLOBAL_DEPTH for globals), and slot is its index
+// among the globals or among the locals (formals included) of
+// its function. Later phases can use the slot to index a frame
+// or the global area directly instead of looking names up.
+// A record's fields are in no scope (FIELD_DEPTH), and their 
+// slot is their index in the record.
+struct SymbolCoord{
+	static const uint32_t FIELD_DEPTH = 0;
+	static const uint32_t GLOBAL_DEPTH = 1;
+	static const uint32_t NO_SLOT = UINT32_MAX;
+
+	SymbolCoord() : depth(0), slot(NO_SLOT){ }
+	SymbolCoord(uint32_t depthIn, uint32_t slotIn)
+	: depth(depthIn), slot(slotIn){ }
+	bool isGlobal() const { return depth == GLOBAL_DEPTH; }
+	bool isField() const { return depth == FIELD_DEPTH && resolved(); }
+	bool resolved() const { return slot != NO_SLOT; }
+
+	uint32_t depth;
+	uint32_t slot;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -2,66 +2,155 @@
 #include "types.hpp"
 namespace cshanty{
 
-SymbolTable::SymbolTable(){
-	scopeTableChain = new std::list<ScopeTable *>();
+const int SymbolTable::NO_BINDING;
+
+SymbolTable::SymbolTable() 
+: depth(0), globalSlots(0), localSlots(0), myStats{0, 0}{
+}
+
+SymbolTable::~SymbolTable(){
+	for (ScopeTable * scope : scopes){
+		delete scope;
+	}
 }
 
 void SymbolTable::print(){
-	for(auto scope : *scopeTableChain){
+	for (size_t d = depth; d > 0; d--){
 		std::cout << "--- scope ---\n";
-		std::cout << scope->toString();
+		std::cout << scopeString(d);
 	}
 }
 
 ScopeTable * SymbolTable::enterScope(){
-	ScopeTable * newScope = new ScopeTable();
-	scopeTableChain->push_front(newScope);
-	return newScope;
+	myStats.scopesEntered++;
+	depth++;
+	if (scopes.size() < depth){
+		scopes.push_back(new ScopeTable(this, depth));
+		scopeNames.emplace_back();
+	}
+	return scopes[depth - 1];
 }
 
 void SymbolTable::leaveScope(){
-	if (scopeTableChain->empty()){
+	if (depth == 0){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
-	scopeTableChain->pop_front();
+	std::vector<SymbolId>& names = scopeNames[depth - 1];
+	for (SymbolId name : names){
+		unbind(name, depth);
+	}
+	names.clear();
+	depth--;
 }
 
 ScopeTable * SymbolTable::getCurrentScope(){
-	return scopeTableChain->front();
+	return scopes[depth - 1];
+}
+
+SymbolCoord SymbolTable::allocSlot(){
+	uint32_t atDepth = static_cast<uint32_t>(depth);
+	if (atDepth == SymbolCoord::GLOBAL_DEPTH){
+		return SymbolCoord(atDepth, globalSlots++);
+	}
+	return SymbolCoord(atDepth, localSlots++);
 }
 
-bool SymbolTable::clash(std::string varName){
+bool SymbolTable::clash(SymbolId varName){
 	bool hasClash = getCurrentScope()->clash(varName);
 	return hasClash;
 }
 
-SemSymbol * SymbolTable::find(std::string varName){
-	for (ScopeTable * scope : *scopeTableChain){
-		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
-	}
-	return nullptr;
+SemSymbol * SymbolTable::find(SymbolId varName){
+	myStats.lookups++;
+	if (varName >= heads.size()){ return nullptr; }
+	int head = heads[varName];
+	if (head == NO_BINDING){ return nullptr; }
+	return bindings[static_cast<size_t>(head)].symbol;
 }
 
 bool SymbolTable::insert(SemSymbol * symbol){
-	return scopeTableChain->front()->insert(symbol);
+	return insertAt(symbol, depth);
 }
 
-ScopeTable::ScopeTable(){
-	symbols = new HashMap<std::string, SemSymbol *>();
+//The binding of name made at exactly the given depth, if any
+int SymbolTable::bindingAt(SymbolId name, size_t atDepth){
+	if (name >= heads.size()){ return NO_BINDING; }
+	int cur = heads[name];
+	while (cur != NO_BINDING){
+		const Binding& binding = bindings[static_cast<size_t>(cur)];
+		if (binding.depth == atDepth){ return cur; }
+		if (binding.depth < atDepth){ return NO_BINDING; }
+		cur = binding.next;
+	}
+	return NO_BINDING;
 }
 
-std::string ScopeTable::toString(){
+SemSymbol * SymbolTable::lookupAt(SymbolId name, size_t atDepth){
+	myStats.lookups++;
+	int found = bindingAt(name, atDepth);
+	if (found == NO_BINDING){ return nullptr; }
+	return bindings[static_cast<size_t>(found)].symbol;
+}
+
+bool SymbolTable::insertAt(SemSymbol * symbol, size_t atDepth){
+	SymbolId name = symbol->getId();
+	if (bindingAt(name, atDepth) != NO_BINDING){ return false; }
+	if (name >= heads.size()){
+		heads.resize(name + 1, NO_BINDING);
+	}
+
+	int index;
+	if (freeBindings.empty()){
+		index = static_cast<int>(bindings.size());
+		bindings.emplace_back();
+	} else {
+		index = freeBindings.back();
+		freeBindings.pop_back();
+	}
+
+	//Chains are ordered innermost first. Bindings are almost
+	// always made in the innermost scope, and so go at the 
+	// head, but a function is added to its enclosing scope
+	// after the scope of its body has been entered.
+	int * link = &heads[name];
+	while (*link != NO_BINDING 
+	  && bindings[static_cast<size_t>(*link)].depth > atDepth){
+		link = &bindings[static_cast<size_t>(*link)].next;
+	}
+	bindings[static_cast<size_t>(index)] = Binding{symbol, atDepth, *link};
+	*link = index;
+	scopeNames[atDepth - 1].push_back(name);
+	return true;
+}
+
+void SymbolTable::unbind(SymbolId name, size_t atDepth){
+	int * link = &heads[name];
+	while (*link != NO_BINDING){
+		Binding& binding = bindings[static_cast<size_t>(*link)];
+		if (binding.depth == atDepth){
+			freeBindings.push_back(*link);
+			*link = binding.next;
+			return;
+		}
+		link = &binding.next;
+	}
+}
+
+std::string SymbolTable::scopeString(size_t atDepth){
 	std::string result = "";
-	for (auto entry : *symbols){
-		result += entry.second->toString();
+	for (SymbolId name : scopeNames[atDepth - 1]){
+		result += lookupAt(name, atDepth)->toString();
 		result += "\n";
 	}
 	return result;
 }
 
-bool ScopeTable::clash(std::string varName){
+std::string ScopeTable::toString(){
+	return table->scopeString(depth);
+}
+
+bool ScopeTable::clash(SymbolId varName){
 	SemSymbol * found = lookup(varName);
 	if (found != nullptr){
 		return true;
@@ -69,22 +158,12 @@ bool ScopeTable::clash(std::string varName){
 	return false;
 }
 
-SemSymbol * ScopeTable::lookup(std::string name){
-	auto found = symbols->find(name);
-	if (found == symbols->end()){
-		return NULL;
-	}
-	return found->second;
+SemSymbol * ScopeTable::lookup(SymbolId name){
+	return table->lookupAt(name, depth);
 }
 
 bool ScopeTable::insert(SemSymbol * symbol){
-	std::string symName = symbol->getName();
-	bool alreadyInScope = (this->lookup(symName) != NULL);
-	if (alreadyInScope){
-		return false;
-	}
-	this->symbols->insert(std::make_pair(symName, symbol));
-	return true;
+	return table->insertAt(symbol, depth);
 }
 
 std::string SemSymbol::toString(){
@@ -3,6 +3,10 @@
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <vector>
+#include "arena.hpp"
+#include "interner.hpp"
+#include "symbol_coord.hpp"
 #include "types.hpp"
 
 //Use an alias template so that we can use
@@ -22,14 +26,19 @@ enum SymbolKind {
 
 //A semantic symbol, which represents a single
 // variable, function, etc. Semantic symbols 
-// exist for the lifetime of a scope in the 
-// symbol table. 
-class SemSymbol {
+// are bound for the lifetime of a scope in the 
+// symbol table, but the IDs in the AST keep
+// pointing at them, so they are placed in the
+// current arena along with the AST.
+class SemSymbol : public ArenaObject {
 public:
-	SemSymbol(std::string nameIn, const DataType * typeIn) 
+	SemSymbol(SymbolId nameIn, const DataType * typeIn) 
 	: myName(nameIn), myType(typeIn){ }
 	virtual std::string toString();
-	std::string getName() const { return myName; }
+	SymbolId getId() const { return myName; }
+	const std::string& getName() const { 
+		return Interner::current()->str(myName);
+	}
 	virtual SymbolKind getKind() const = 0;
 
 	virtual const DataType * getDataType() const{
@@ -44,74 +53,142 @@ public:
 		return "UNKNOWN KIND";
 	} 
 private:
-	std::string myName;
+	SymbolId myName;
 	const DataType * myType;
 };
 
 class VarSymbol : public SemSymbol {
 public:
-	VarSymbol(std::string name, const DataType * type) 
+	VarSymbol(SymbolId name, const DataType * type) 
 	: SemSymbol(name, type) { }
 	virtual SymbolKind getKind() const override { return VAR; } 
+	SymbolCoord getCoord() const { return myCoord; }
+	void setCoord(SymbolCoord coord){ myCoord = coord; }
+private:
+	SymbolCoord myCoord;
 };
 
 class FnSymbol : public SemSymbol{
 public:
-	FnSymbol(std::string name, const FnType * fnType)
-	: SemSymbol(name, fnType){ }
+	FnSymbol(SymbolId name, const FnType * fnType)
+	: SemSymbol(name, fnType), frameSize(0){ }
 	virtual SymbolKind getKind() const { return FN; }
 	SymbolKind getKind(){ return FN; } 
+	//The number of local slots (formals included) the 
+	// function's variables were given
+	size_t getFrameSize() const { return frameSize; }
+	void setFrameSize(size_t size){ frameSize = size; }
+private:
+	size_t frameSize;
 };
 
 class RecordSymbol : public SemSymbol{
 public:
-	RecordSymbol(std::string name, const RecordType * record)
+	RecordSymbol(SymbolId name, const RecordType * record)
 	: SemSymbol(name, record){ }
 	virtual SymbolKind getKind() const { return RECORD; }
 	SymbolKind getKind(){ return RECORD; }
 };
 
+class SymbolTable;
+
+//How much work a symbol table has done, for --stats
+struct SymbolTableStats{
+	size_t scopesEntered;
+	size_t lookups;
+};
+
 //A single scope. The symbol table is broken down into a 
-// chain of scope tables, and each scope table holds 
-// semantic symbols for a single scope. For example,
-// the globals scope will be represented by a ScopeTable,
-// and the contents of each function can be represented by
-// a ScopeTable.
+// chain of scopes, and each scope holds semantic symbols
+// for a single scope. For example, the globals scope will 
+// be represented by a ScopeTable, and the contents of each 
+// function can be represented by a ScopeTable. A ScopeTable
+// is only a view of one nesting depth of the SymbolTable;
+// the symbols themselves are stored in the SymbolTable.
 class ScopeTable {
 	public:
-		ScopeTable();
-		SemSymbol * lookup(std::string name);
+		ScopeTable(SymbolTable * tableIn, size_t depthIn)
+		: table(tableIn), depth(depthIn){ }
+		SemSymbol * lookup(SymbolId name);
 		bool insert(SemSymbol * symbol);
-		bool clash(std::string name);
+		bool clash(SymbolId name);
 		std::string toString();
-		void addVar(std::string name, const DataType * type){
+		void addVar(SymbolId name, const DataType * type){
 			insert(new VarSymbol(name, type));
 		}
-		void addFn(std::string name, FnType * type){
+		void addFn(SymbolId name, const FnType * type){
 			insert(new FnSymbol(name, type));
 		}
 	private:
-		HashMap<std::string, SemSymbol *> * symbols;
+		SymbolTable * table;
+		size_t depth;
 };
 
+//All of the scopes currently open, kept in one flat table 
+// indexed by SymbolId. Each identifier has a chain of the 
+// bindings visible for it, innermost first, so find() only
+// ever looks at the head of one chain no matter how deeply
+// scopes are nested. Each open scope keeps a log of the 
+// names bound in it, which leaveScope() uses to unlink 
+// exactly those bindings again.
 class SymbolTable{
 	public:
 		SymbolTable();
+		~SymbolTable();
 		ScopeTable * enterScope();
 		void leaveScope();
 		ScopeTable * getCurrentScope();
 		bool insert(SemSymbol * symbol);
-		SemSymbol * find(std::string varName);
-		bool clash(std::string name);
-		void addVar(std::string name, const DataType * type){
+		SemSymbol * find(SymbolId varName);
+		bool clash(SymbolId name);
+		void addVar(SymbolId name, const DataType * type){
 			getCurrentScope()->addVar(name, type);
 		}
-		void addFn(std::string name, FnType * type){
+		void addFn(SymbolId name, const FnType * type){
 			getCurrentScope()->addFn(name, type);
 		}
 		void print();
+
+		//Give a variable about to be declared in the current
+		// scope the next global slot, or the next slot of 
+		// the function being analyzed
+		SymbolCoord allocSlot();
+		//Start numbering the slots of a new function's locals
+		void beginFrame(){ localSlots = 0; }
+		//The number of local slots used by the current function
+		size_t frameSize() const { return localSlots; }
+		size_t globalCount() const { return globalSlots; }
+		const SymbolTableStats& stats() const { return myStats; }
+
+		//Operations on the scope at a given depth (the 
+		// global scope has depth 1), used by ScopeTable
+		SemSymbol * lookupAt(SymbolId name, size_t depth);
+		bool insertAt(SemSymbol * symbol, size_t depth);
+		std::string scopeString(size_t depth);
 	private:
-		std::list<ScopeTable *> * scopeTableChain;
+		static const int NO_BINDING = -1;
+		struct Binding{
+			SemSymbol * symbol;
+			size_t depth;
+			int next;
+		};
+		int bindingAt(SymbolId name, size_t depth);
+		void unbind(SymbolId name, size_t depth);
+
+		//Head of the binding chain of each SymbolId
+		std::vector<int> heads;
+		//Storage for the bindings, and the unused slots in it
+		std::vector<Binding> bindings;
+		std::vector<int> freeBindings;
+		//For each open scope, the names bound in it. The 
+		// vectors (and ScopeTables) of closed scopes are kept
+		// for reuse by the next scope opened at that depth.
+		std::vector<std::vector<SymbolId>> scopeNames;
+		std::vector<ScopeTable *> scopes;
+		size_t depth;
+		uint32_t globalSlots;
+		uint32_t localSlots;
+		SymbolTableStats myStats;
 };
 
 	
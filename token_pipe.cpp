@@ -0,0 +1,82 @@
+#include <thread>
+#include "token_pipe.hpp"
+
+namespace cshanty{
+
+//END is token kind 0; the END token carries the end of the
+// input in place of a span
+static const uint16_t END_KIND = 0;
+
+TokenPipe::TokenPipe(size_t capacity)
+: slots(capacity), mask(capacity - 1),
+  tail(0), headSeen(0), fullStalls(0),
+  head(0), tailSeen(0), emptyStalls(0),
+  occupancySum(0), occupancySamples(0), occupancyMax(0){
+}
+
+void TokenPipe::push(int kind, size_t start, size_t end, uint32_t value){
+	put(PipedToken{static_cast<uint32_t>(start), 
+		static_cast<uint32_t>(end), value, static_cast<uint16_t>(kind)});
+}
+
+void TokenPipe::close(size_t endLine, size_t endCol){
+	put(PipedToken{static_cast<uint32_t>(endLine), 
+		static_cast<uint32_t>(endCol), 0, END_KIND});
+}
+
+void TokenPipe::put(const PipedToken& token){
+	size_t at = tail.load(std::memory_order_relaxed);
+	if (at - headSeen == slots.size()){
+		headSeen = head.load(std::memory_order_acquire);
+		if (at - headSeen == slots.size()){
+			fullStalls++;
+			do {
+				std::this_thread::yield();
+				headSeen = head.load(std::memory_order_acquire);
+			} while (at - headSeen == slots.size());
+		}
+	}
+	slots[at & mask] = token;
+	tail.store(at + 1, std::memory_order_release);
+}
+
+bool TokenPipe::pop(PipedToken * token, size_t * endLine, size_t * endCol){
+	size_t at = head.load(std::memory_order_relaxed);
+	if (at == tailSeen){
+		tailSeen = tail.load(std::memory_order_acquire);
+		if (at == tailSeen){
+			emptyStalls++;
+			do {
+				std::this_thread::yield();
+				tailSeen = tail.load(std::memory_order_acquire);
+			} while (at == tailSeen);
+		}
+		size_t waiting = tailSeen - at;
+		occupancySum += waiting;
+		occupancySamples++;
+		if (waiting > occupancyMax){ occupancyMax = waiting; }
+	}
+	*token = slots[at & mask];
+	head.store(at + 1, std::memory_order_release);
+	if (token->kind == END_KIND){
+		*endLine = token->start;
+		*endCol = token->end;
+		return false;
+	}
+	return true;
+}
+
+PipelineStats TokenPipe::counters() const{
+	PipelineStats stats;
+	stats.used = true;
+	stats.capacity = slots.size();
+	stats.lexerStalls = fullStalls;
+	stats.parserStalls = emptyStalls;
+	stats.meanOccupancy = occupancySamples == 0 ? 0 
+		: static_cast<double>(occupancySum) 
+		  / static_cast<double>(occupancySamples);
+	stats.maxOccupancy = occupancyMax;
+	return stats;
+}
+
+} //End namespace cshanty
@@ -0,0 +1,75 @@
+#ifndef CSHANTY_TOKEN_PIPE_HPP
+#define CSHANTY_TOKEN_PIPE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "stats.hpp"
+
+namespace cshanty{
+
+//One token on its way from the scanner to the parser
+struct PipedToken{
+	uint32_t start;
+	uint32_t end;
+	uint32_t value;
+	uint16_t kind;
+};
+
+//A bounded, lock-free ring of tokens from a scanner on one
+// thread to the parser on another, so that lexing and parsing
+// overlap. There must be exactly one thread pushing and one
+// popping. Each side keeps its own copy of where the other
+// has got to and only reads the other's index when that copy
+// says the ring is full (or empty), so the two threads rarely
+// touch the same cache line. A side that finds the ring full
+// (or empty) yields until it isn't; each such wait is counted
+// as a stall.
+class TokenPipe{
+public:
+	//Must be a power of two
+	static const size_t DEFAULT_CAPACITY = 4096;
+
+	TokenPipe(size_t capacity = DEFAULT_CAPACITY);
+
+	//Called by the scanner's thread
+	void push(int kind, size_t start, size_t end, uint32_t value);
+	//No more tokens; the end of the input is at endLine, endCol
+	void close(size_t endLine, size_t endCol);
+
+	//Called by the parser's thread. Takes the next token, or
+	// returns false once the pipe is closed and empty, having
+	// stored the end of the input in endLine and endCol.
+	bool pop(PipedToken * token, size_t * endLine, size_t * endCol);
+
+	//How the pipe was used, once both sides are done with it
+	PipelineStats counters() const;
+private:
+	void put(const PipedToken& token);
+
+	std::vector<PipedToken> slots;
+	size_t mask;
+	char padSlots[64];
+
+	//The scanner's side
+	std::atomic<size_t> tail;
+	size_t headSeen;
+	size_t fullStalls;
+	char padTail[64];
+
+	//The parser's side
+	std::atomic<size_t> head;
+	size_t tailSeen;
+	size_t emptyStalls;
+	//The tokens waiting each time the parser caught up with
+	// what it had last seen
+	size_t occupancySum;
+	size_t occupancySamples;
+	size_t occupancyMax;
+	char padHead[64];
+};
+
+} //End namespace cshanty
+
+#endif
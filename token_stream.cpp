@@ -0,0 +1,75 @@
+#include <string>
+#include "token_pipe.hpp"
+#include "token_stream.hpp"
+
+namespace cshanty{
+
+using TokenKind = cshanty::Parser::token;
+
+int TokenStream::next(Parser::semantic_type * const lval){
+	if (cursor >= kinds.size() && !pull()){
+		return TokenKind::END;
+	}
+	size_t index = cursor++;
+	lval->transToken = TokenRef{this, static_cast<uint32_t>(index)};
+	return kinds[index];
+}
+
+void TokenStream::splice(TokenStream * other){
+	kinds.insert(kinds.end(), other->kinds.begin(), other->kinds.end());
+	spans.insert(spans.end(), other->spans.begin(), other->spans.end());
+	values.insert(values.end(), other->values.begin(), other->values.end());
+	other->kinds.clear();
+	other->spans.clear();
+	other->values.clear();
+}
+
+void TokenStream::clear(){
+	kinds.clear();
+	spans.clear();
+	values.clear();
+	cursor = 0;
+}
+
+bool TokenStream::pull(){
+	if (pipe == nullptr){ return false; }
+	PipedToken token;
+	if (!pipe->pop(&token, &endLine, &endCol)){
+		pipe = nullptr;
+		return false;
+	}
+	append(token.kind, token.start, token.end, token.value);
+	return true;
+}
+
+void TokenStream::drain(){
+	while (pull()){ }
+}
+
+size_t TokenStream::bytes() const{
+	return kinds.capacity() * sizeof(uint16_t)
+		+ spans.capacity() * sizeof(Position)
+		+ values.capacity() * sizeof(uint32_t);
+}
+
+void TokenStream::output(std::ostream& outstream) const{
+	for (size_t i = 0; i < kinds.size(); i++){
+		int kind = kinds[i];
+		outstream << tokenKindName(kind);
+		if (kind == TokenKind::ID || kind == TokenKind::STRLITERAL){
+			SourceView text = view(i);
+			outstream << ":";
+			outstream.write(text.data(),
+				static_cast<std::streamsize>(text.length()));
+		} else if (kind == TokenKind::INTLITERAL){
+			outstream << ":" << static_cast<int>(values[i]);
+		}
+		outstream << " " << spans[i].begin() << "\n";
+	}
+	outstream << "EOF" 
+	  << " [" << endLine 
+	  << "," << endCol << "]"
+	  << std::endl;
+}
+
+} //End namespace cshanty
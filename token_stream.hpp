@@ -0,0 +1,91 @@
+#ifndef CSHANTY_TOKEN_STREAM_HPP
+#define CSHANTY_TOKEN_STREAM_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "grammar.hh"
+#include "position.hpp"
+#include "source_buffer.hpp"
+#include "tokens.hpp"
+
+namespace cshanty{
+
+class TokenPipe;
+
+//The complete token stream of an input file. The scanner
+// fills the stream once, after which it can be written out
+// (the -t flag) and handed to the parser as many times as
+// needed without re-lexing the input.
+//
+//Tokens are kept as parallel arrays of their kind, their span
+// in the source and a value (the SymbolId of an ID, the value
+// of an INTLITERAL), rather than as an object apiece. The text
+// of a token is read back out of the source when needed.
+//
+//A stream can instead be filled as it is read, from a scanner
+// on another thread that feeds it through a TokenPipe.
+class TokenStream{
+public:
+	TokenStream(const SourceBuffer * sourceIn)
+	: source(sourceIn), pipe(nullptr), cursor(0), endLine(1), 
+	  endCol(1){ }
+	void append(int kind, size_t start, size_t end, uint32_t value = 0){
+		kinds.push_back(static_cast<uint16_t>(kind));
+		spans.push_back(Position(start, end));
+		values.push_back(value);
+	}
+	//Append every token of other, which is left empty
+	void splice(TokenStream * other);
+	void clear();
+	//Take tokens from pipe, once those already in the stream
+	// have been read, until it is closed
+	void pullFrom(TokenPipe * pipeIn){ pipe = pipeIn; }
+	//Take every token left in the pipe, so that the stream is
+	// complete
+	void drain();
+	void setEnd(size_t lineNum, size_t colNum){
+		endLine = lineNum;
+		endCol = colNum;
+	}
+
+	//Hand the next token to the parser, in the same manner
+	// as Scanner::yylex. Once the stream is exhausted, END
+	// is returned.
+	int next(Parser::semantic_type * const lval);
+	void rewind(){ cursor = 0; }
+	size_t size() const { return kinds.size(); }
+	void output(std::ostream& outstream) const;
+
+	int kind(size_t index) const { return kinds[index]; }
+	Position * pos(size_t index){ return &spans[index]; }
+	uint32_t value(size_t index) const { return values[index]; }
+	void setValue(size_t index, uint32_t value){ values[index] = value; }
+	SourceView view(size_t index) const {
+		const Position& span = spans[index];
+		return source->view(span.startOffset(),
+			span.endOffset() - span.startOffset());
+	}
+
+	//The bytes the token arrays take up
+	size_t bytes() const;
+	size_t endLineNum() const { return endLine; }
+	size_t endColNum() const { return endCol; }
+private:
+	//Append the next token from the pipe, or return false if
+	// there are no more
+	bool pull();
+
+	const SourceBuffer * source;
+	TokenPipe * pipe;
+	std::vector<uint16_t> kinds;
+	std::vector<Position> spans;
+	std::vector<uint32_t> values;
+	size_t cursor;
+	size_t endLine;
+	size_t endCol;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -1,12 +1,12 @@
 #include "tokens.hpp" // Get the class declarations
 #include "grammar.hh" // Get the TokenKind definitions
+#include "token_stream.hpp"
 
 namespace cshanty{
 
 using TokenKind = cshanty::Parser::token;
-using Lexeme = cshanty::Parser::semantic_type;
 
-static std::string tokenKindString(int tokKind){
+const char * tokenKindName(int tokKind){
 	switch(tokKind){
 		case TokenKind::END: return "EOF";
 		case TokenKind::AND: return "AND";
@@ -54,60 +54,24 @@ static std::string tokenKindString(int tokKind){
 	
 }
 
-Token::Token(Position * posIn, int kindIn)
-  : myPos(posIn), myKind(kindIn){
+int TokenRef::kind() const {
+	return stream->kind(index);
 }
 
-std::string Token::toString(){
-	return tokenKindString(kind())
-	+ " " + myPos->begin();
+Position * TokenRef::pos() const {
+	return stream->pos(index);
 }
 
-int Token::kind() const { 
-	return this->myKind; 
+SourceView TokenRef::view() const {
+	return stream->view(index);
 }
 
-Position * Token::pos() const {
-	return myPos;
+SymbolId TokenRef::id() const {
+	return stream->value(index);
 }
 
-IDToken::IDToken(Position * posIn, std::string vIn)
-  : Token(posIn, TokenKind::ID), myValue(vIn){ 
-}
-
-std::string IDToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ myValue + " " + myPos->begin();
-}
-
-const std::string IDToken::value() const { 
-	return this->myValue; 
-}
-
-StrToken::StrToken(Position * posIn, std::string sIn)
-  : Token(posIn, TokenKind::STRLITERAL), myStr(sIn){
-}
-
-std::string StrToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ this->myStr + " " + myPos->begin();
-}
-
-const std::string StrToken::str() const {
-	return this->myStr;
-}
-
-IntLitToken::IntLitToken(Position * pos, int numIn)
-  : Token(pos, TokenKind::INTLITERAL), myNum(numIn){}
-
-std::string IntLitToken::toString(){
-	return tokenKindString(kind()) + ":"
-	+ std::to_string(this->myNum) + " "
-	+ myPos->begin();
-}
-
-int IntLitToken::num() const {
-	return this->myNum;
+int TokenRef::num() const {
+	return static_cast<int>(stream->value(index));
 }
 
 } //End namespace cshanty
@@ -1,51 +1,39 @@
 #ifndef CSHANTY_TOKEN_H
 #define CSHANTY_TOKEN_H
 
+#include <cstdint>
 #include <string>
+#include "arena.hpp"
+#include "interner.hpp"
 #include "position.hpp"
+#include "source_buffer.hpp"
 
 namespace cshanty{
 
-class Token{
-public:
-	Token(Position * pos, int kindIn);
-	virtual std::string toString();
-	size_t line() const;
-	size_t col() const;
-	int kind() const;
-	Position * pos() const;
-protected:
-	Position * myPos;
-private:
-	const int myKind;
-};
+class TokenStream;
 
-class IDToken : public Token{
-public:
-	IDToken(Position * posIn, std::string valIn);
-	const std::string value() const;
-	virtual std::string toString() override;
-private:
-	const std::string myValue;
-	
-};
+//The name of a kind of token, as the -t flag writes it
+const char * tokenKindName(int kind);
 
-class StrToken : public Token{
-public:
-	StrToken(Position * posIn, std::string valIn);
-	virtual std::string toString() override;
-	const std::string str() const;
-private:
-	const std::string myStr;
-};
+//A token in a TokenStream, as handed to the parser. Tokens
+// aren't objects of their own: a TokenRef is only an index
+// into the stream's arrays, so it is as cheap to copy as a
+// pointer and can sit in the parser's semantic value.
+struct TokenRef{
+	TokenStream * stream;
+	uint32_t index;
 
-class IntLitToken : public Token{
-public:
-	IntLitToken(Position * posIn, int numIn);
-	virtual std::string toString() override;
+	int kind() const;
+	//The span of the token, which lives as long as the stream
+	Position * pos() const;
+	//The text of the token in the source
+	SourceView view() const;
+	//The identifier an ID token names
+	SymbolId id() const;
+	//The value of an INTLITERAL token
 	int num() const;
-private:
-	const int myNum;
+	//The text (quotes included) of a STRLITERAL token
+	std::string str() const { return view().str(); }
 };
 
 }
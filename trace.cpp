@@ -0,0 +1,99 @@
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <set>
+#include <unistd.h>
+#include "trace.hpp"
+
+namespace cshanty{
+
+static thread_local TraceLog * currentLog = nullptr;
+
+//Small, stable IDs for threads, in the order they first record
+// a span, which trace viewers show more readably than the 
+// system's thread IDs
+static uint32_t traceThreadId(){
+	static std::atomic<uint32_t> nextId(1);
+	static thread_local uint32_t id = 0;
+	if (id == 0){ id = nextId++; }
+	return id;
+}
+
+TraceLog * TraceLog::current(){
+	return currentLog;
+}
+
+TraceLog::Scope::Scope(TraceLog * log) : previous(currentLog){
+	currentLog = log;
+}
+
+TraceLog::Scope::~Scope(){
+	currentLog = previous;
+}
+
+void TraceLog::add(const char * category, std::string name, 
+	Clock::time_point start, Clock::time_point end
+){
+	std::chrono::duration<double, std::micro> startUs = start - epoch;
+	std::chrono::duration<double, std::micro> durationUs = end - start;
+	uint32_t thread = traceThreadId();
+	std::lock_guard<std::mutex> guard(lock);
+	events.push_back(Event{std::move(name), category, 
+		startUs.count(), durationUs.count(), thread});
+}
+
+void writeJsonString(std::ostream& out, const std::string& str){
+	out << '"';
+	for (char c : str){
+		unsigned char u = static_cast<unsigned char>(c);
+		if (c == '"' || c == '\\'){
+			out << '\\' << c;
+		} else if (u < 0x20){
+			const char * hex = "0123456789abcdef";
+			out << "\\u00" << hex[u >> 4] << hex[u & 0xf];
+		} else {
+			out << c;
+		}
+	}
+	out << '"';
+}
+
+bool TraceLog::write(const char * path){
+	std::ofstream out(path);
+	if (!out.good()){ return false; }
+	long pid = static_cast<long>(getpid());
+	std::lock_guard<std::mutex> guard(lock);
+	std::set<uint32_t> threads;
+	out << std::fixed << std::setprecision(3);
+	out << "{\"traceEvents\": [";
+	const char * sep = "\n  ";
+	for (const Event& event : events){
+		threads.insert(event.thread);
+		out << sep << "{\"name\": ";
+		writeJsonString(out, event.name);
+		out << ", \"cat\": \"" << event.category << "\""
+		  << ", \"ph\": \"X\", \"ts\": " << event.startUs 
+		  << ", \"dur\": " << event.durationUs
+		  << ", \"pid\": " << pid << ", \"tid\": " << event.thread 
+		  << "}";
+		sep = ",\n  ";
+	}
+	for (uint32_t thread : threads){
+		out << sep << "{\"name\": \"thread_name\", \"ph\": \"M\""
+		  << ", \"pid\": " << pid << ", \"tid\": " << thread
+		  << ", \"args\": {\"name\": \"cshantyc " << thread << "\"}}";
+	}
+	out << "\n], \"displayTimeUnit\": \"ms\"}\n";
+	return out.good();
+}
+
+void TraceSpan::finish(){
+	std::string full = name;
+	if (detail != nullptr){
+		full += " ";
+		full += *detail;
+	}
+	log->add(category, std::move(full), start, TraceLog::Clock::now());
+}
+
+} //End namespace cshanty
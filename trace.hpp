@@ -0,0 +1,92 @@
+#ifndef CSHANTY_TRACE_HPP
+#define CSHANTY_TRACE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cshanty{
+
+//Spans of work collected for the --trace flag, written out in
+// the Chrome trace event format (which Perfetto also reads)
+class TraceLog{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	TraceLog() : epoch(Clock::now()){ }
+
+	//Record a span, on the calling thread, that has finished
+	void add(const char * category, std::string name, 
+		Clock::time_point start, Clock::time_point end);
+
+	//Write every span recorded so far. Returns false if the 
+	// file can't be written.
+	bool write(const char * path);
+
+	//The log that spans begun on this thread are added to, or
+	// nullptr if this thread isn't being traced
+	static TraceLog * current();
+
+	//Traces the calling thread into a log (which may be null,
+	// to trace nothing) for the lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(TraceLog * log);
+		~Scope();
+	private:
+		TraceLog * previous;
+	};
+private:
+	struct Event{
+		std::string name;
+		const char * category;
+		double startUs;
+		double durationUs;
+		uint32_t thread;
+	};
+	Clock::time_point epoch;
+	std::mutex lock;
+	std::vector<Event> events;
+};
+
+//A span of work, from construction to destruction, in the 
+// current TraceLog. When the thread isn't being traced, a span
+// costs a thread-local load and a branch at each end.
+class TraceSpan{
+public:
+	TraceSpan(const char * categoryIn, const char * nameIn)
+	: log(TraceLog::current()), category(categoryIn), 
+	  name(nameIn), detail(nullptr){
+		if (log != nullptr){ start = TraceLog::Clock::now(); }
+	}
+	//A span named "name detail", e.g. for the function a 
+	// declaration is of. detail must outlive the span.
+	TraceSpan(const char * categoryIn, const char * nameIn, 
+		const std::string& detailIn)
+	: log(TraceLog::current()), category(categoryIn), 
+	  name(nameIn), detail(&detailIn){
+		if (log != nullptr){ start = TraceLog::Clock::now(); }
+	}
+	~TraceSpan(){
+		if (log != nullptr){ finish(); }
+	}
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+private:
+	void finish();
+	TraceLog * log;
+	const char * category;
+	const char * name;
+	const std::string * detail;
+	TraceLog::Clock::time_point start;
+};
+
+//Write str as a quoted, escaped JSON string
+void writeJsonString(std::ostream& out, const std::string& str);
+
+} //End namespace cshanty
+
+#endif
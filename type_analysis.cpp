@@ -1,22 +1,33 @@
+#include <vector>
 #include "ast.hpp"
 #include "symbol_table.hpp"
 #include "errors.hpp"
 #include "types.hpp"
 #include "name_analysis.hpp"
 #include "type_analysis.hpp"
+#include "trace.hpp"
+#include "type_context.hpp"
 
 namespace cshanty{
 
-TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis){
+TypeAnalysis * TypeAnalysis::build(NameAnalysis * nameAnalysis, 
+	size_t * entriesOut
+){
 	//To emphasize that type analysis depends on name analysis
 	// being complete, a name analysis must be supplied for 
 	// type analysis to be performed.
 	TypeAnalysis * typeAnalysis = new TypeAnalysis();
 	auto ast = nameAnalysis->ast;	
 	typeAnalysis->ast = ast;
+	NodeIds * ids = NodeIds::current();
+	if (ids != nullptr){ typeAnalysis->nodeToType.reserve(ids->size()); }
 
 	ast->typeAnalysis(typeAnalysis);
+	if (entriesOut != nullptr){ 
+		*entriesOut = typeAnalysis->nodeToType.size();
+	}
 	if (typeAnalysis->hasError){
+		delete typeAnalysis;
 		return nullptr;
 	}
 
@@ -43,6 +54,7 @@ void ProgramNode::typeAnalysis(TypeAnalysis * ta){
 }
 
 void FnDeclNode::typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) {
+	TraceSpan span("types", "fn", myID->getName());
 	const DataType * retType = myRetType->getType();
 	for (auto stmt : *myBody){
 		stmt->typeAnalysis(ta, retType);
@@ -102,7 +114,8 @@ void ReturnStmtNode::typeAnalysis(TypeAnalysis * ta, const DataType * currentFnT
 	}
 	
 	
-	ta->nodeType(this, ta->nodeType(myExp));
+	//A bare return (in a void function) has no expression
+	ta->nodeType(this, returnType);
 }
 
 void AssignStmtNode::typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType) {
@@ -184,22 +197,19 @@ void CallExpNode::typeAnalysis(TypeAnalysis * ta) {
 	}
 	else {
 		auto formalTypes = fnType->asFn()->getFormalTypes();
-		if (formalTypes->size() != myArgs->size())
+		if (formalTypes.size() != myArgs->size())
 		{
 			ta->errArgCount(this->pos());
 			error = true;
 		}
 		
-		ExpNode ** argArr = new ExpNode*[myArgs->size()];
-		int arrPos = 0;
-		for (auto arg : *myArgs) {
-			argArr[arrPos] = arg;
-			++arrPos;
-		}
+		std::vector<ExpNode *> argArr(myArgs->begin(), myArgs->end());
 
-		arrPos = 0;
-		for (auto type : *formalTypes)
+		size_t arrPos = 0;
+		for (auto type : formalTypes)
 		{
+			//A call with too few args has already been reported
+			if (arrPos >= argArr.size()){ break; }
 			argArr[arrPos]->typeAnalysis(ta);
 			auto argType = ta->nodeType(argArr[arrPos]);
 			if (type != argType)
@@ -789,25 +799,27 @@ void TypeNode::typeAnalysis(TypeAnalysis * ta){
 //doing this beacues there is nor record testing in p5
 
 void RecordTypeNode::typeAnalysis(TypeAnalysis * ta){
-	myID->typeAnalysis(ta);
+	//The ID names a record, which name analysis doesn't attach
+	// to it, so there is nothing to type it with
 	//still needs work i think
 	//might need errors 
-	HashMap<std::string, const DataType *> *junk = new HashMap<std::string, const DataType *>();
+	HashMap<SymbolId, const DataType *> junk;
 	const DataType * junkType = BasicType::produce(VOID);
-	std::pair<std::string, const DataType *> junkPair(std::string("junk"), junkType);
-	junk->insert(junkPair);
-	ta->nodeType(this, RecordType::produce("none", junk));
+	std::pair<SymbolId, const DataType *> junkPair(Interner::current()->intern("junk"), junkType);
+	junk.insert(junkPair);
+	ta->nodeType(this, TypeContext::current()->recordType("none", std::move(junk)));
 }
 
 void RecordTypeDeclNode::typeAnalysis(TypeAnalysis * ta, const DataType * currentFnType){
-	myID->typeAnalysis(ta);
+	TraceSpan span("types", "record", myID->getName());
+	//As in RecordTypeNode, the ID has no symbol to type it with
 	//still needs work i think
 	//might need errors 
-	HashMap<std::string, const DataType *> *junk = new HashMap<std::string, const DataType *>();
+	HashMap<SymbolId, const DataType *> junk;
 	const DataType * junkType = BasicType::produce(VOID);
-	std::pair<std::string, const DataType *> junkPair(std::string("junk"), junkType);
-	junk->insert(junkPair);
-	ta->nodeType(this, RecordType::produce("none", junk));
+	std::pair<SymbolId, const DataType *> junkPair(Interner::current()->intern("junk"), junkType);
+	junk.insert(junkPair);
+	ta->nodeType(this, TypeContext::current()->recordType("none", std::move(junk)));
 }
 
 //doing this beacues there is nor record testing in p5
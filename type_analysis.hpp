@@ -15,18 +15,22 @@ namespace cshanty{
 // TypeAnalysis class contains a map from each ASTNode to it's
 // DataType. Thus, instead of attaching a type field to most nodes,
 // one can instead map the node to it's type, or lookup the node
-// in the map.
+// in the map. The map is a vector indexed by the node's ID, so
+// neither operation hashes anything.
 class TypeAnalysis {
 
 private:
 	//The private constructor here means that the type analysis
 	// can only be created via the static build function
-	TypeAnalysis(){
+	TypeAnalysis() : nodeToType(nullptr){
 		hasError = false;
 	}
 
 public:
-	static TypeAnalysis * build(NameAnalysis * astRoot);
+	//If entriesOut is given, the number of nodes given a type
+	// is left there, whether or not the analysis succeeds
+	static TypeAnalysis * build(NameAnalysis * astRoot, 
+		size_t * entriesOut = nullptr);
 	//static TypeAnalysis * build();
 
 	//The type analysis has an instance variable to say whether
@@ -50,19 +54,19 @@ public:
 	// overloaded: this 2-argument nodeType puts a value into the
 	// map with a given type. 
 	void nodeType(const ASTNode * node, const DataType * type){
-		nodeToType[node] = type;
+		nodeToType.set(node, type);
 	}
 
 	//Gets the type of a node already placed in the map. Note
 	// that this function name is overloaded: the 1-argument nodeType
 	// gets the type of the given node out of the map.
 	const DataType * nodeType(const ASTNode * node){
-		const DataType * res = nodeToType[node];
+		const DataType * res = nodeToType.get(node);
 		if (res == nullptr){
 			const char * msg = "No type for node ";
 			throw new InternalError(msg);
 		}
-		return nodeToType[node];
+		return res;
 	}
 
 	//The following functions all report and error and 
@@ -181,7 +185,7 @@ public:
 		Report::fatal(pos, "Bad index type");
 	}
 private:
-	HashMap<const ASTNode *, const DataType *> nodeToType;
+	NodeMap<ASTNode, const DataType *> nodeToType;
 	const FnType * currentFnType;
 	bool hasError;
 public:
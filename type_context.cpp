@@ -0,0 +1,74 @@
+#include "type_context.hpp"
+
+namespace cshanty{
+
+static thread_local TypeContext * currentContext = nullptr;
+
+TypeContext::~TypeContext(){
+	for (auto entry : fnTypes){
+		delete entry.second;
+	}
+	for (auto entry : recordTypes){
+		delete entry.second;
+	}
+}
+
+bool TypeContext::FnKey::operator==(const FnKey& other) const{
+	if (ret != other.ret || count != other.count){ return false; }
+	for (size_t i = 0; i < count; i++){
+		if (formals[i] != other.formals[i]){ return false; }
+	}
+	return true;
+}
+
+//The component types are already unique, so hashing their 
+// addresses is enough
+size_t TypeContext::FnKeyHash::operator()(const FnKey& key) const{
+	std::hash<const DataType *> hashType;
+	size_t hash = hashType(key.ret);
+	for (size_t i = 0; i < key.count; i++){
+		hash = hash * 31 + hashType(key.formals[i]);
+	}
+	return hash;
+}
+
+const FnType * TypeContext::fnType(
+	const std::vector<const DataType *>& formals,
+	const DataType * retType
+){
+	FnKey probe{formals.data(), formals.size(), retType};
+	auto found = fnTypes.find(probe);
+	if (found != fnTypes.end()){ return found->second; }
+
+	FnType * type = new FnType(formals, retType);
+	const std::vector<const DataType *>& own = type->getFormalTypes();
+	fnTypes.emplace(FnKey{own.data(), own.size(), retType}, type);
+	return type;
+}
+
+const RecordType * TypeContext::recordType(
+	const std::string& name,
+	HashMap<SymbolId, const DataType *>&& fields
+){
+	auto found = recordTypes.find(name);
+	if (found != recordTypes.end()){ return found->second; }
+
+	RecordType * type = new RecordType(name, std::move(fields));
+	recordTypes[name] = type;
+	return type;
+}
+
+TypeContext * TypeContext::current(){
+	return currentContext;
+}
+
+TypeContext::Scope::Scope(TypeContext * context) 
+: previous(currentContext){
+	currentContext = context;
+}
+
+TypeContext::Scope::~Scope(){
+	currentContext = previous;
+}
+
+} //End namespace cshanty
@@ -0,0 +1,69 @@
+#ifndef CSHANTY_TYPE_CONTEXT_HPP
+#define CSHANTY_TYPE_CONTEXT_HPP
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "types.hpp"
+
+namespace cshanty{
+
+//Owns the structured types built while compiling one input.
+// Function types are hash-consed: asking for the same formal
+// and return types twice gives back the same FnType, so two 
+// function types are equal exactly when they are the same
+// pointer, and each distinct signature is allocated once no 
+// matter how many functions share it. Record types are kept 
+// by name. Since all of this state belongs to one compilation
+// (the basic and error types are immutable constants), any
+// number of compilations can run at once on different threads.
+class TypeContext{
+public:
+	TypeContext(){ }
+	~TypeContext();
+	TypeContext(const TypeContext&) = delete;
+	TypeContext& operator=(const TypeContext&) = delete;
+
+	const FnType * fnType(const std::vector<const DataType *>& formals,
+		const DataType * retType);
+	//The number of distinct function types built
+	size_t fnTypeCount() const { return fnTypes.size(); }
+
+	//The record type with the given name. The fields are only
+	// used the first time a name is asked for.
+	const RecordType * recordType(const std::string& name,
+		HashMap<SymbolId, const DataType *>&& fields);
+
+	//The type context that types built by this thread are 
+	// kept in
+	static TypeContext * current();
+
+	//Makes a type context current for the calling thread for
+	// the lifetime of the Scope object
+	class Scope{
+	public:
+		Scope(TypeContext * context);
+		~Scope();
+	private:
+		TypeContext * previous;
+	};
+private:
+	//A key refers either to the formals being looked up or
+	// to those of an existing FnType
+	struct FnKey{
+		const DataType * const * formals;
+		size_t count;
+		const DataType * ret;
+		bool operator==(const FnKey& other) const;
+	};
+	struct FnKeyHash{
+		size_t operator()(const FnKey& key) const;
+	};
+	std::unordered_map<FnKey, const FnType *, FnKeyHash> fnTypes;
+	HashMap<std::string, const RecordType *> recordTypes;
+};
+
+} //End namespace cshanty
+
+#endif
@@ -6,9 +6,18 @@
 
 namespace cshanty{
 
+const ErrorType ErrorType::error;
+
+const BasicType BasicType::flyweights[4] = {
+	BasicType(BaseType::INT),
+	BasicType(BaseType::VOID),
+	BasicType(BaseType::STRING),
+	BasicType(BaseType::BOOL),
+};
+
 std::string BasicType::getString() const{
 	std::string res = "";
-	switch(myBaseType){
+	switch(getBaseType()){
 	case BaseType::INT:
 		res += "int";
 		break;
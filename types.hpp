@@ -3,7 +3,10 @@
 
 #include <list>
 #include <sstream>
+#include <utility>
+#include <vector>
 #include "errors.hpp"
+#include "interner.hpp"
 
 #include <unordered_map>
 
@@ -28,122 +31,99 @@ enum BaseType{
 	INT, VOID, STRING, BOOL
 };
 
+//What kind of type a DataType is. The four basic kinds come 
+// first, in the same order as BaseType, so a BasicType's kind
+// is just its BaseType.
+enum class TypeKind : unsigned char{
+	INT, VOID, STRING, BOOL, RECORD, FN, ERROR
+};
+
 //This class is the superclass for all cshanty types. You
 // can get information about which type is implemented
 // concretely using the as<X> functions, or query information
-// using the is<X> functions.
+// using the is<X> functions. Both only test the kind tag 
+// stored in the type, so they can be inlined rather than 
+// going through a virtual call.
 class DataType{
 public:
 	virtual std::string getString() const = 0;
-	virtual const BasicType * asBasic() const { return nullptr; }
-	virtual const RecordType * asRecord() const { return nullptr; }
-	virtual const FnType * asFn() const { return nullptr; }
-	virtual const ErrorType * asError() const { return nullptr; }
-	virtual bool isVoid() const { return false; }
-	virtual bool isInt() const { return false; }
-	virtual bool isBool() const { return false; }
-	virtual bool isString() const { return false; }
-	virtual bool isRecord() const { return false; }
+	TypeKind getKind() const { return myKind; }
+	inline const BasicType * asBasic() const;
+	inline const RecordType * asRecord() const;
+	inline const FnType * asFn() const;
+	inline const ErrorType * asError() const;
+	bool isBasic() const { return myKind <= TypeKind::BOOL; }
+	bool isVoid() const { return myKind == TypeKind::VOID; }
+	bool isInt() const { return myKind == TypeKind::INT; }
+	bool isBool() const { return myKind == TypeKind::BOOL; }
+	bool isString() const { return myKind == TypeKind::STRING; }
+	bool isRecord() const { return myKind == TypeKind::RECORD; }
+	bool isFn() const { return myKind == TypeKind::FN; }
+	bool isError() const { return myKind == TypeKind::ERROR; }
 	virtual bool validVarType() const = 0 ;
 	virtual size_t getSize() const = 0;
 protected:
+	constexpr DataType(TypeKind kindIn) : myKind(kindIn){ }
+private:
+	TypeKind myKind;
 };
 
 //This DataType subclass is the superclass for all cshanty types. 
 // Note that there is exactly one instance of this 
 class ErrorType : public DataType{
 public:
-	static ErrorType * produce(){
-		//Note: this static member will only ever be initialized 
-		// ONCE, no matter how many times the function is called.
-		// That means there will only ever be 1 instance of errorType
-		// in the entire codebase.
-		static ErrorType * error = new ErrorType();
-		
-		return error;
-	}
-	virtual const ErrorType * asError() const override { return this; }
+	static constexpr const ErrorType * produce(){
+		//There is only ever 1 instance of errorType in the 
+		// entire codebase, built at compile time.
+		return &error;
+	}
 	virtual std::string getString() const override { 
 		return "ERROR";
 	}
 	virtual bool validVarType() const override { return false; }
 	virtual size_t getSize() const override { return 0; }
 private:
-	ErrorType(){ 
+	constexpr ErrorType() : DataType(TypeKind::ERROR){ 
 		/* private constructor, can only 
-		be called from produce */
+		be called for the single instance */
 	}
-	size_t line;
-	size_t col;
+	static const ErrorType error;
 };
 
 //DataType subclass for all scalar types 
 class BasicType : public DataType{
 public:
-	static BasicType * VOID(){
+	static constexpr const BasicType * VOID(){
 		return produce(BaseType::VOID);
 	}
-	static BasicType * BOOL(){
+	static constexpr const BasicType * BOOL(){
 		return produce(BaseType::BOOL);
 	}
-	static BasicType * STRING(){
+	static constexpr const BasicType * STRING(){
 		return produce(BaseType::STRING);
 	}
-	static BasicType * INT(){
+	static constexpr const BasicType * INT(){
 		return produce(BaseType::INT);
 	}
 
-	//Create a scalar type. If that type already exists,
-	// return the known instance of that type. Making sure
-	// there is only 1 instance of a class for a given set
-	// of fields is known as the "flyweight" design pattern
-	// and ensures that the memory needs of a program are kept
-	// down: rather than having a distinct type for every base
-	// INT (for example), only one is constructed and kept in
-	// the flyweights list. That type is then re-used anywhere
-	// it's needed. 
-
-	//Note the use of the static function declaration, which 
-	// means that no instance of BasicType is needed to call
-	// the function.
-	static BasicType * produce(BaseType base){
-		//Note the use of the static local variable, which
-		//means that the flyweights variable persists between
-		// multiple calls to this function (it is essentially
-		// a global variable that can only be accessed
-		// in this function).
-		static std::list<BasicType *> flyweights;
-		for(BasicType * fly : flyweights){
-			if (fly->getBaseType() == base){
-				return fly;
-			}
-		}
-		BasicType * newType = new BasicType(base);
-		flyweights.push_back(newType);
-		return newType;
-	}
-	const BasicType * asBasic() const override {
-		return this;
-	}
-	BasicType * asBasic(){
-		return this;
-	}
-	bool isInt() const override {
-		return myBaseType == BaseType::INT;
-	}
-	bool isString() const override {
-		return myBaseType == BaseType::STRING;
-	}
-	bool isBool() const override {
-		return myBaseType == BaseType::BOOL;
-	}
-	virtual bool isVoid() const override { 
-		return myBaseType == BaseType::VOID; 
+	//Get the scalar type for a base type. There is exactly 1
+	// instance of each, so that types can be compared by 
+	// address. Making sure there is only 1 instance of a class
+	// for a given set of fields is known as the "flyweight" 
+	// design pattern and ensures that the memory needs of a 
+	// program are kept down: rather than having a distinct type
+	// for every base INT (for example), only one is used 
+	// anywhere it's needed. The instances are constant-
+	// initialized, so getting one is just taking an address.
+	static constexpr const BasicType * produce(BaseType base){
+		return &flyweights[base];
 	}
 	virtual bool validVarType() const override {
 		return !isVoid();
 	}
-	virtual BaseType getBaseType() const { return myBaseType; }
+	BaseType getBaseType() const { 
+		return static_cast<BaseType>(getKind());
+	}
 	virtual std::string getString() const override;
 	virtual size_t getSize() const override { 
 		if (isBool()){ return 1; }
@@ -153,61 +133,47 @@ public:
 		else { return 0; }
 	}
 private:
-	BasicType(BaseType base) 
-	: myBaseType(base){ }
-	BaseType myBaseType;
+	constexpr BasicType(BaseType base) 
+	: DataType(static_cast<TypeKind>(base)){ }
+	//Indexed by BaseType
+	static const BasicType flyweights[4];
 };
 
-class RecordType : public DataType{
+//DataType subclass for records. RecordTypes are only built by
+// a TypeContext, which keeps one per record name declared in
+// the compilation.
+class RecordType final : public DataType{
 public:
-	//static RecordType * produce(std::list<DataType *>, std::string name){
-	static RecordType * produce(std::string name, HashMap<std::string, const DataType *> * fields){
-		static HashMap <std::string, RecordType *> map;
-
-		//TODO: find a node
-		RecordType * r;
-		auto res = map.find(name);
-		if (res == map.end()){
-			RecordType * r = new RecordType(name, fields);
-			map[name] = r;
-			return r;
-		} else {
-			return res->second;
-		}
-	};
 	bool validVarType() const override { return true; }
 	std::string getString() const override { return name; }
 	size_t getSize() const override { TODO(Implement); }
-	const RecordType * asRecord() const override { return this; }
-	bool isRecord() const override { return true; }
 
-	const DataType * getField(std::string fieldName) const{
-		auto res = fieldTypes->find(fieldName);
-		if (res == fieldTypes->end()){ return nullptr; }
+	const DataType * getField(SymbolId fieldName) const{
+		auto res = fieldTypes.find(fieldName);
+		if (res == fieldTypes.end()){ return nullptr; }
 		return res->second;
 	}
 private:
-	RecordType(std::string nameIn, HashMap<std::string, const DataType *> * fieldsIn) 
-	: name(nameIn), fieldTypes(fieldsIn){ 
+	friend class TypeContext;
+	RecordType(std::string nameIn, 
+		HashMap<SymbolId, const DataType *>&& fieldsIn) 
+	: DataType(TypeKind::RECORD), name(nameIn), 
+	  fieldTypes(std::move(fieldsIn)){ 
 	}
 	std::string name;
-	HashMap<std::string, const DataType *> *fieldTypes;
+	HashMap<SymbolId, const DataType *> fieldTypes;
 };
 
 //DataType subclass to represent the type of a function. It will
-// have a list of argument types and a return type. 
-class FnType : public DataType{
+// have an array of argument types and a return type. FnTypes are
+// only built by a TypeContext, which makes sure there is one per
+// distinct signature.
+class FnType final : public DataType{
 public:
-	FnType(const std::list<const DataType *>* formalsIn, const DataType * retTypeIn) 
-	: DataType(),
-	  myFormalTypes(formalsIn),
-	  myRetType(retTypeIn)
-	{
-	}
 	std::string getString() const override{
 		std::string result = "";
 		bool first = true;
-		for (auto elt : *myFormalTypes){
+		for (auto elt : myFormalTypes){
 			if (first) { first = false; }
 			else { result += ","; }
 			result += elt->getString();
@@ -216,21 +182,47 @@ public:
 		result += myRetType->getString();
 		return result;
 	}
-	virtual const FnType * asFn() const override { return this; }
-
 	const DataType * getReturnType() const {
 		return myRetType;
 	}
-	const std::list<const DataType *> * getFormalTypes() const {
+	const std::vector<const DataType *>& getFormalTypes() const {
 		return myFormalTypes;
 	}
 	virtual bool validVarType() const override { return false; }
 	virtual size_t getSize() const override { return 0; }
 private:
-	const std::list<const DataType *> * myFormalTypes;
+	friend class TypeContext;
+	FnType(const std::vector<const DataType *>& formalsIn, 
+		const DataType * retTypeIn) 
+	: DataType(TypeKind::FN),
+	  myFormalTypes(formalsIn),
+	  myRetType(retTypeIn)
+	{
+	}
+	const std::vector<const DataType *> myFormalTypes;
 	const DataType * myRetType;
 };
 
+inline const BasicType * DataType::asBasic() const { 
+	if (!isBasic()){ return nullptr; }
+	return static_cast<const BasicType *>(this);
+}
+
+inline const RecordType * DataType::asRecord() const { 
+	if (!isRecord()){ return nullptr; }
+	return static_cast<const RecordType *>(this);
+}
+
+inline const FnType * DataType::asFn() const { 
+	if (!isFn()){ return nullptr; }
+	return static_cast<const FnType *>(this);
+}
+
+inline const ErrorType * DataType::asError() const { 
+	if (!isError()){ return nullptr; }
+	return static_cast<const ErrorType *>(this);
+}
+
 }
 
 #endif
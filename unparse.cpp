@@ -314,7 +314,7 @@ void LValNode::unparseNested(std::ostream& out){
 
 void IDNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
-	out << name;
+	out << getName();
 	if (mySymbol != nullptr){
 		out << "("
 		  << mySymbol->getDataType()->getString()
@@ -329,7 +329,7 @@ void IntLitNode::unparse(std::ostream& out, int indent){
 
 void StrLitNode::unparse(std::ostream& out, int indent){
 	doIndent(out, indent);
-	out << myStr;
+	out.write(myStr.data(), static_cast<std::streamsize>(myStr.length()));
 }
 
 void FalseNode::unparse(std::ostream& out, int indent){